@@ -12,6 +12,7 @@
 #include <cassert>
 #include <cstring>
 
+#include <algorithm>
 #include <array>
 #include <unordered_map>
 #include <vector>
@@ -300,6 +301,12 @@ class bitVector {
         return curent_rank;
     }
 
+    // bring the data needed for rank(pos) into cache
+    void prefetch(uint64_t pos) const {
+        __builtin_prefetch(_bitArray + (pos >> 6ULL));
+        __builtin_prefetch(_ranks.data() + pos / _nb_bits_per_rank_sample);
+    }
+
     uint64_t rank(uint64_t pos) const {
         uint64_t word_idx = pos / 64ULL;
         uint64_t word_offset = pos % 64;
@@ -366,6 +373,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw, hash_domain));
+    }
+
     uint64_t hash_domain;
     bitVector bitset;
 };
@@ -473,12 +484,7 @@ class mphf {
         uint64_t level_hash = getLevel(bbhash, &level, _nb_levels);
 
         if (level == (_nb_levels-1)) {
-            auto in_final_map = _final_hash.find(bbhash);
-            if (in_final_map == _final_hash.end())
-                return NOT_FOUND;
-
-            return (in_final_map->second != NOT_FOUND ?
-                    in_final_map->second + _lastbitsetrank : NOT_FOUND);
+            return lookupFinal(bbhash);
         } else {
             non_minimal_hp = fastrange64(level_hash, _levels[level].hash_domain);
         }
@@ -486,6 +492,68 @@ class mphf {
         return _levels[level].bitset.rank(non_minimal_hp); // minimal_hp
     }
 
+    static constexpr unsigned LOOKUP_BATCH = 16;
+
+    // Batched lookup: res[i] = phfs[i]->lookup(elems[i]). All the elements are hashed
+    // first and then resolved level by level, the bit vector data of the whole batch
+    // is prefetched before probing, so the cache misses of different elements overlap.
+    // Different elements may be looked up in different functions (e.g. buckets).
+    template<class elem_t>
+    static void lookup(const mphf *const *phfs, const elem_t *elems, size_t n, uint64_t *res) {
+        hash_pair_t hashes[LOOKUP_BATCH], states[LOOKUP_BATCH];
+        uint64_t level_hashes[LOOKUP_BATCH];
+        unsigned pending[LOOKUP_BATCH];
+
+        for (size_t start = 0; start < n; start += LOOKUP_BATCH) {
+            unsigned cnt = unsigned(std::min<size_t>(LOOKUP_BATCH, n - start));
+            unsigned npending = 0;
+            for (unsigned i = 0; i < cnt; ++i) {
+                const mphf &phf = *phfs[start + i];
+                if (!phf._built) {
+                    res[start + i] = NOT_FOUND;
+                    continue;
+                }
+                states[i] = hashes[i] = phf._hasher.hashpair128(elems[start + i]);
+                pending[npending++] = i;
+            }
+
+            for (unsigned level = 0; npending; ++level) {
+                for (unsigned j = 0; j < npending; ++j) {
+                    unsigned i = pending[j];
+                    const mphf &phf = *phfs[start + i];
+                    if (level < phf._nb_levels - 1) {
+                        level_hashes[i] = phf.iterate_hash(states[i], level);
+                        phf._levels[level].prefetch(level_hashes[i]);
+                    }
+                }
+
+                unsigned left = 0;
+                for (unsigned j = 0; j < npending; ++j) {
+                    unsigned i = pending[j];
+                    const mphf &phf = *phfs[start + i];
+                    if (level == phf._nb_levels - 1) {
+                        res[start + i] = phf.lookupFinal(hashes[i]);
+                    } else if (phf._levels[level].get(level_hashes[i])) {
+                        const auto &lvl = phf._levels[level];
+                        res[start + i] = lvl.bitset.rank(fastrange64(level_hashes[i], lvl.hash_domain));
+                    } else {
+                        pending[left++] = i;
+                    }
+                }
+                npending = left;
+            }
+        }
+    }
+
+    // prefetch the first level data for the element, most of the elements are found there
+    template<class elem_t>
+    void prefetch(const elem_t &elem) const {
+        if (!_built) return;
+
+        hash_pair_t bbhash = _hasher.hashpair128(elem);
+        _levels[0].prefetch(iterate_hash(bbhash, 0));
+    }
+
     uint64_t size() const {
         return _nelem;
     }
@@ -605,6 +673,15 @@ class mphf {
         return _hasher.next(bbhash);
     }
 
+    uint64_t lookupFinal(const hash_pair_t &bbhash) const {
+        auto in_final_map = _final_hash.find(bbhash);
+        if (in_final_map == _final_hash.end())
+            return NOT_FOUND;
+
+        return (in_final_map->second != NOT_FOUND ?
+                in_final_map->second + _lastbitsetrank : NOT_FOUND);
+    }
+
     // compute level and returns hash of last level reached
     uint64_t getLevel(internal_hash_t bbhash, unsigned *res_level, unsigned maxlevel) const {
         unsigned level = 0;
@@ -179,6 +179,11 @@ public:
         return *runs_[winner_index].begin();
     }
 
+    // Index of the run the current top element comes from
+    size_t top_run() const {
+        return entry_[0];
+    }
+
     void replay() {
         size_t winner_index = entry_[0];
         entry_[0] = replay(winner_index);
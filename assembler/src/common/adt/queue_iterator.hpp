@@ -15,6 +15,7 @@
 #include <parallel_hashmap/phmap.h>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
 namespace {
 template<typename T>
@@ -190,6 +191,180 @@ public:
     }
 };
 
+// Maps integral priorities to buckets one to one, the larger ones share the last bucket
+template<size_t MaxBucket = (1 << 14)>
+struct integer_buckets {
+    template<typename P>
+    size_t operator()(const P &p) const {
+        if (!(p > P(0)))
+            return 0;
+        return p < P(MaxBucket) ? size_t(p) : MaxBucket;
+    }
+};
+
+// Maps non-negative priorities to buckets of width 1 / Scale, the larger ones share the last bucket
+template<unsigned Scale = 8, size_t MaxBucket = (1 << 14)>
+struct quantized_buckets {
+    size_t operator()(double p) const {
+        double b = p * Scale;
+        if (!(b > 0))
+            return 0;
+        return b < double(MaxBucket) ? size_t(b) : MaxBucket;
+    }
+};
+
+/**
+ * Same ordering as erasable_priority_queue_key_dirty_heap, but the elements are distributed into
+ * buckets by their priorities first. Buckets must be a non-decreasing function of the priority.
+ * Only the lowest non-empty bucket is kept as a heap, so pushes into the other buckets take O(1)
+ * and the heap operations work on a single bucket. Erased elements are dropped from the set of
+ * alive ones and left in their buckets until they reach the top or the storage is compressed.
+ */
+template<typename T, typename Priority, typename Buckets>
+class erasable_priority_queue_key_buckets {
+private:
+    static const size_t NO_BUCKET = size_t(-1);
+
+    using PriorityValue = std::decay_t<decltype(std::declval<Priority>()(T()))>;
+    using StoredType = std::pair<PriorityValue, T>;
+
+    Priority priority_;
+    Buckets bucket_;
+    std::vector<std::vector<StoredType>> buckets_;
+    // Bitmap of the buckets which could be non-empty
+    std::vector<uint64_t> occupied_;
+    phmap::flat_hash_set<StoredType> set_;
+    size_t stored_;
+    // All the buckets below are empty, the bucket is a heap with an alive top
+    size_t cur_;
+
+    size_t NextOccupied(size_t b) const {
+        for (size_t w = b / 64; w < occupied_.size(); ++w) {
+            uint64_t word = occupied_[w];
+            if (w == b / 64)
+                word &= ~uint64_t(0) << (b % 64);
+            if (word)
+                return w * 64 + __builtin_ctzll(word);
+        }
+        return NO_BUCKET;
+    }
+
+    void Put(const StoredType &p) {
+        size_t b = bucket_(p.first);
+        if (b >= buckets_.size()) {
+            buckets_.resize(b + 1);
+            occupied_.resize(b / 64 + 1);
+        }
+        auto &bucket = buckets_[b];
+        bucket.push_back(p);
+        occupied_[b / 64] |= uint64_t(1) << (b % 64);
+        ++stored_;
+        if (b == cur_)
+            std::push_heap(bucket.begin(), bucket.end(), simple_greater());
+        else if (cur_ == NO_BUCKET || b < cur_)
+            cur_ = b;
+    }
+
+    void skip() {
+        if (empty()) return clear();
+
+        while (true) {
+            auto &bucket = buckets_[cur_];
+            while (!bucket.empty() && !set_.count(bucket.front())) {
+                std::pop_heap(bucket.begin(), bucket.end(), simple_greater());
+                bucket.pop_back();
+                --stored_;
+            }
+            if (!bucket.empty())
+                return;
+
+            occupied_[cur_ / 64] &= ~(uint64_t(1) << (cur_ % 64));
+            cur_ = NextOccupied(cur_ + 1);
+            VERIFY(cur_ != NO_BUCKET);
+            std::make_heap(buckets_[cur_].begin(), buckets_[cur_].end(), simple_greater());
+        }
+    }
+
+public:
+    erasable_priority_queue_key_buckets(Priority priority = Priority(), Buckets buckets = Buckets())
+            : priority_(std::move(priority)), bucket_(std::move(buckets)),
+              stored_(0), cur_(NO_BUCKET) {}
+
+    template<typename InputIterator>
+    erasable_priority_queue_key_buckets(InputIterator begin, InputIterator end,
+                                        Priority priority = Priority(), Buckets buckets = Buckets())
+            : erasable_priority_queue_key_buckets(std::move(priority), std::move(buckets)) {
+        insert(begin, end);
+    }
+
+    void pop() {
+        VERIFY(!set_.empty());
+        auto &bucket = buckets_[cur_];
+        bool res __attribute__((unused)) = set_.erase(bucket.front());
+        VERIFY(res);
+        std::pop_heap(bucket.begin(), bucket.end(), simple_greater());
+        bucket.pop_back();
+        --stored_;
+        skip();
+    }
+
+    const T& top() const {
+        VERIFY(!set_.empty());
+        return buckets_[cur_].front().second;
+    }
+
+    void push(const T &key) {
+        auto p = std::make_pair(priority_(key), key);
+        if (set_.insert(p).second)
+            Put(p);
+    }
+
+    bool erase(const T &key) {
+        bool res = set_.erase(std::make_pair(priority_(key), key)) > 0;
+        if (!res)
+            return false;
+        skip();
+        if (2 * set_.size() < stored_)
+            compress();
+        return true;
+    }
+
+    void clear() {
+        set_.clear();
+        buckets_.clear();
+        occupied_.clear();
+        stored_ = 0;
+        cur_ = NO_BUCKET;
+    }
+
+    void compress() {
+        for (auto &bucket : buckets_)
+            bucket.clear();
+        std::fill(occupied_.begin(), occupied_.end(), 0);
+        stored_ = 0;
+        cur_ = NO_BUCKET;
+        for (const auto &p : set_)
+            Put(p);
+        if (cur_ != NO_BUCKET)
+            std::make_heap(buckets_[cur_].begin(), buckets_[cur_].end(), simple_greater());
+    }
+
+    bool empty() const {
+        return set_.empty();
+    }
+
+    size_t size() const {
+        return set_.size();
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator begin, InputIterator end) {
+        for (; begin != end; ++begin) {
+            push(*begin);
+        }
+    }
+};
+
 template<typename T, typename Priority=identity>
 class erasable_priority_queue_key {
 private:
@@ -525,6 +700,15 @@ public:
             : base(priority) {}
 };
 
+// Iterator over queue that is ordered using Priority mapped to buckets by Buckets
+template<typename T, typename Priority, typename Buckets>
+class DynamicQueueIteratorBuckets : public DynamicQueueIteratorBase<T, erasable_priority_queue_key_buckets<T, Priority, Buckets>> {
+    using base = DynamicQueueIteratorBase<T, erasable_priority_queue_key_buckets<T, Priority, Buckets>>;
+public:
+    DynamicQueueIteratorBuckets(const Priority &priority = Priority(), const Buckets &buckets = Buckets())
+            : base(priority, buckets) {}
+};
+
 // Iterator over quuue that is ordered using Comparator
 template<typename T, typename Comparator = std::less<T>>
 class DynamicQueueIterator : public DynamicQueueIteratorBase<T, indexed_heap_erasable_priority_queue<T, Comparator>> {
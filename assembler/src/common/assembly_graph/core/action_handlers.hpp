@@ -126,6 +126,30 @@ public:
         return false;
     }
 
+    /**
+     * Descendants which may receive the events with a delay should override this method, see
+     * ObservableGraph::BeginEventBatch(). Such handler gets the events of the batch in bulk and
+     * concurrently with other batchable handlers, so it must only modify its own state and only read
+     * the graph elements passed to it. Its state must not be read until the batch is flushed.
+     */
+    virtual bool IsBatchable() const {
+        return false;
+    }
+
+    /**
+     * Called for the batchable handlers by ObservableGraph::FlushEvents() before the events of the
+     * batch are delivered.
+     */
+    virtual void HandleBatchStart() { }
+
+    /**
+     * Called for the batchable handlers by ObservableGraph::FlushEvents() after all the events of the
+     * batch were delivered. The handlers are called one at a time, so a handler which deferred the
+     * processing of the events may finish it here using all the threads. The removed graph elements
+     * are still available at this point.
+     */
+    virtual void HandleBatchEnd() { }
+
     bool IsAttached() const {
         return attached_;
     }
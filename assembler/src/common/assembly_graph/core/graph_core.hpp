@@ -647,14 +647,24 @@ protected:
         return result;
     }
 
-    void HiddenDeleteEdge(EdgeId e) {
-        TRACE("Hidden delete edge " << e.int_id());
+    // Removes the edge and its conjugate from the adjacency lists, the edges themselves
+    // stay alive (with their data and ends) until HiddenDestroyEdge()
+    void HiddenUnlinkEdge(EdgeId e) {
         EdgeId rcEdge = conjugate(e);
         VertexId rcStart = conjugate(edge(e).end());
         VertexId start = conjugate(edge(rcEdge).end());
         vertex(start).RemoveOutgoingEdge(e);
         vertex(rcStart).RemoveOutgoingEdge(rcEdge);
-        DestroyEdge(e, rcEdge);
+    }
+
+    void HiddenDestroyEdge(EdgeId e) {
+        DestroyEdge(e, conjugate(e));
+    }
+
+    void HiddenDeleteEdge(EdgeId e) {
+        TRACE("Hidden delete edge " << e.int_id());
+        HiddenUnlinkEdge(e);
+        HiddenDestroyEdge(e);
     }
 
     void HiddenDeletePath(const std::vector<EdgeId>& edgesToDelete,
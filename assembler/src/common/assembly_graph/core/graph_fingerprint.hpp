@@ -0,0 +1,54 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "xxh/xxhash.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace omnigraph {
+
+/**
+ * @brief  Hash of the graph content: k, edge and vertex ids, edge links and edge
+ *         nucleotides. It does not depend on the iteration order, so it can be used
+ *         to check that some saved graph-derived structure still matches the graph.
+ */
+template<class Graph>
+uint64_t GraphFingerprint(const Graph &g) {
+    typedef typename Graph::EdgeId EdgeId;
+
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+
+    uint64_t res = 0;
+#   pragma omp parallel
+    {
+        std::vector<uint64_t> words;
+#       pragma omp for reduction(+ : res)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i];
+            const auto &nucls = g.EdgeNucls(e);
+
+            // Repack the nucleotides, the sequence might be a reverse-complement
+            // or a subsequence of some other buffer
+            words.assign((nucls.size() + 31) / 32, 0);
+            for (size_t j = 0; j < nucls.size(); ++j)
+                words[j / 32] |= uint64_t(nucls[j]) << (2 * (j % 32));
+
+            uint64_t rec[] = { g.k(), e.int_id(), g.conjugate(e).int_id(),
+                               g.EdgeStart(e).int_id(), g.EdgeEnd(e).int_id(),
+                               nucls.size() };
+            uint64_t h = XXH3_64bits_withSeed(words.data(), words.size() * sizeof(uint64_t),
+                                              XXH3_64bits(rec, sizeof(rec)));
+            res += h;
+        }
+    }
+
+    return res;
+}
+
+}
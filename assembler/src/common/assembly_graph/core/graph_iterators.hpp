@@ -178,15 +178,32 @@ SmartEdgeSet<Container, Graph> make_smart_edge_set(const Graph &g, Container &c,
     return SmartEdgeSet<Container, Graph>(g, c, std::forward<Args>(args)...);
 }
 
+template<class... Ts>
+struct make_void { typedef void type; };
+
+/**
+ * Queue used by the smart iterators for the given Priority. Priorities which provide buckets_type
+ * mapping their values to integers get the bucketed queue, the others are kept in a heap.
+ */
+template<typename ElementId, typename Priority, typename = void>
+struct SmartIteratorQueue {
+    typedef adt::DynamicQueueIteratorKey<ElementId, Priority> type;
+};
+
+template<typename ElementId, typename Priority>
+struct SmartIteratorQueue<ElementId, Priority, typename make_void<typename Priority::buckets_type>::type> {
+    typedef adt::DynamicQueueIteratorBuckets<ElementId, Priority, typename Priority::buckets_type> type;
+};
+
 /**
  * SmartIterator is able to iterate through collection content of which can be changed in process of
  * iteration. And as GraphActionHandler SmartIterator can change collection contents with respect to the
  * way graph is changed. Also one can define order of iteration by specifying Priority.
  */
-template<class Graph, typename ElementId, typename Priority = adt::identity>
+template<class Graph, typename ElementId, typename Priority = adt::identity,
+         typename DynamicQueueIterator = typename SmartIteratorQueue<ElementId, Priority>::type>
 class SmartIterator : public GraphActionHandler<Graph> {
     typedef GraphActionHandler<Graph> base;
-    typedef adt::DynamicQueueIteratorKey<ElementId, Priority> DynamicQueueIterator;
     DynamicQueueIterator inner_it_;
     bool add_new_;
     bool canonical_only_;
@@ -11,6 +11,8 @@
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <set>
 #include <cstring>
@@ -40,6 +42,44 @@ private:
    mutable std::vector<Handler*> action_handler_list_;
    std::unique_ptr<const HandlerApplier<VertexId, EdgeId>> applier_;
 
+   enum class EventType : uint8_t {
+       AddVertex, AddEdge, DeleteVertex, DeleteEdge, Merge, Glue, Split
+   };
+
+   // Merge stores the offset and the length of its path in event_edges_ and the new edge
+   struct Event {
+       EventType type;
+       uint64_t ids[3];
+   };
+
+   static const size_t MAX_BATCHED_EVENTS = 1 << 20;
+
+   // Batched event mode state, see BeginEventBatch()
+   unsigned batch_depth_;
+   std::vector<Handler*> handler_order_;
+   mutable std::vector<Handler*> batched_handlers_;
+   mutable std::vector<Event> event_log_;
+   mutable std::vector<EdgeId> event_edges_;
+   std::vector<EdgeId> deferred_edges_;
+   std::vector<VertexId> deferred_vertices_;
+
+   // Not synchronized, the parallel code using the construction helper checks that no batch is active
+   void LogEvent(EventType type, uint64_t id1, uint64_t id2 = 0, uint64_t id3 = 0) const {
+       if (!batched_handlers_.empty())
+           event_log_.push_back({ type, { id1, id2, id3 } });
+   }
+
+   void ReplayEvents(Handler &handler) const;
+
+   void RemoveEdge(EdgeId e);
+
+   void RemoveVertex(VertexId v);
+
+   void MaybeFlushEvents() {
+       if (event_log_.size() >= MAX_BATCHED_EVENTS)
+           FlushEvents();
+   }
+
 public:
 //todo move to graph core
     typedef ConstructionHelper<DataMaster> HelperT;
@@ -47,6 +87,7 @@ public:
     HelperT GetConstructionHelper() {
 //      TODO: fix everything and restore this check
 //      VERIFY(this->VerifyAllDetached());
+        VERIFY_MSG(!InEventBatch(), "Construction helper requested in the batched event mode");
         return HelperT(*this);
     }
 
@@ -60,6 +101,28 @@ public:
 
     bool AllHandlersThreadSafe() const;
 
+    /**
+     * Starts the batched event mode. The events are still delivered immediately to the handlers which
+     * are not batchable (see ActionHandler::IsBatchable()). For the batchable ones the events are
+     * recorded in a log and delivered by FlushEvents(), each handler replaying the log in order and
+     * the handlers running in parallel. Until the flush the removed vertices and edges are only
+     * unlinked from the graph: their ids are not reused and they are still contained in the graph
+     * (and listed by the plain iterators), so the code run in this mode should only walk the graph
+     * structure or use smart iterators. The mode may be nested.
+     */
+    void BeginEventBatch();
+
+    /**
+     * Delivers the recorded events to the batchable handlers and destroys the removed elements.
+     */
+    void FlushEvents();
+
+    void EndEventBatch();
+
+    bool InEventBatch() const {
+        return batch_depth_ > 0;
+    }
+
    // TODO: for debug. remove.
     void PrintHandlersNames() const;
 
@@ -110,7 +173,8 @@ public:
     void FireDeletePath(const std::vector<EdgeId>& edges_to_delete, const std::vector<VertexId>& vertices_to_delete) const;
 
     ObservableGraph(const DataMaster& master) :
-            base(master), applier_(new PairedHandlerApplier<ObservableGraph>(*this)) {
+            base(master), applier_(new PairedHandlerApplier<ObservableGraph>(*this)),
+            batch_depth_(0) {
     }
 
     virtual ~ObservableGraph();
@@ -171,7 +235,8 @@ void ObservableGraph<DataMaster>::DeleteVertex(VertexId v) {
     VERIFY(base::IsDeadEnd(v) && base::IsDeadStart(v));
     VERIFY(v != VertexId());
     FireDeleteVertex(v);
-    base::HiddenDeleteVertex(v);
+    RemoveVertex(v);
+    MaybeFlushEvents();
 }
 
 template<class DataMaster>
@@ -201,7 +266,28 @@ ObservableGraph<DataMaster>::AddEdge(const EdgeData& data, EdgeId id1, EdgeId id
 template<class DataMaster>
 void ObservableGraph<DataMaster>::DeleteEdge(EdgeId e) {
     FireDeleteEdge(e);
-    base::HiddenDeleteEdge(e);
+    RemoveEdge(e);
+    MaybeFlushEvents();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::RemoveEdge(EdgeId e) {
+    if (batched_handlers_.empty()) {
+        base::HiddenDeleteEdge(e);
+        return;
+    }
+
+    // Batched handlers might still need the edge data
+    base::HiddenUnlinkEdge(e);
+    deferred_edges_.push_back(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::RemoveVertex(VertexId v) {
+    if (batched_handlers_.empty())
+        base::HiddenDeleteVertex(v);
+    else
+        deferred_vertices_.push_back(v);
 }
 
 template<class DataMaster>
@@ -270,7 +356,8 @@ void ObservableGraph<DataMaster>::AddActionHandler(Handler* action_handler) cons
 #pragma omp critical(action_handler_list_modification)
     {
         TRACE("Action handler " << action_handler->name() << " added");
-        if (std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler) != action_handler_list_.end()) {
+        if (std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler) != action_handler_list_.end() ||
+            std::find(batched_handlers_.begin(), batched_handlers_.end(), action_handler) != batched_handlers_.end()) {
             VERIFY_MSG(false, "Action handler " << action_handler->name() << " has already been added");
         } else {
             action_handler_list_.push_back(action_handler);
@@ -288,6 +375,11 @@ bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_hand
             action_handler_list_.erase(it);
             TRACE("Action handler " << action_handler->name() << " removed");
             result = true;
+        } else if ((it = std::find(batched_handlers_.begin(), batched_handlers_.end(), action_handler)) != batched_handlers_.end()) {
+            // The events not flushed yet are dropped
+            batched_handlers_.erase(it);
+            TRACE("Batched action handler " << action_handler->name() << " removed");
+            result = true;
         } else {
             TRACE("Action handler " << action_handler->name() << " wasn't found among graph action handlers");
         }
@@ -329,6 +421,7 @@ void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
             applier_->ApplyAdd(*handler_ptr, v);
         }
     }
+    LogEvent(EventType::AddVertex, v.int_id());
 }
 
 template<class DataMaster>
@@ -339,6 +432,7 @@ void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
             applier_->ApplyAdd(*handler_ptr, e);
         }
     }
+    LogEvent(EventType::AddEdge, e.int_id());
 }
 
 template<class DataMaster>
@@ -348,6 +442,7 @@ void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
             applier_->ApplyDelete(**it, v);
         }
     }
+    LogEvent(EventType::DeleteVertex, v.int_id());
 }
 
 template<class DataMaster>
@@ -357,6 +452,7 @@ void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
             applier_->ApplyDelete(**it, e);
         }
     };
+    LogEvent(EventType::DeleteEdge, e.int_id());
 }
 
 template<class DataMaster>
@@ -366,6 +462,10 @@ void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges
             applier_->ApplyMerge(*handler_ptr, old_edges, new_edge);
         }
     }
+    if (!batched_handlers_.empty()) {
+        LogEvent(EventType::Merge, event_edges_.size(), old_edges.size(), new_edge.int_id());
+        event_edges_.insert(event_edges_.end(), old_edges.begin(), old_edges.end());
+    }
 }
 
 template<class DataMaster>
@@ -375,6 +475,7 @@ void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId
             applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2);
         }
     };
+    LogEvent(EventType::Glue, new_edge.int_id(), edge1.int_id(), edge2.int_id());
 }
 
 template<class DataMaster>
@@ -384,6 +485,108 @@ void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeI
             applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2);
         }
     }
+    LogEvent(EventType::Split, edge.int_id(), new_edge1.int_id(), new_edge2.int_id());
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::BeginEventBatch() {
+    if (batch_depth_++)
+        return;
+
+    handler_order_ = action_handler_list_;
+    std::vector<Handler*> immediate;
+    for (Handler *handler : action_handler_list_) {
+        if (handler->IsAttached() && handler->IsBatchable())
+            batched_handlers_.push_back(handler);
+        else
+            immediate.push_back(handler);
+    }
+    action_handler_list_ = std::move(immediate);
+    TRACE("Event batch started, " << batched_handlers_.size() << " batched handlers");
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::ReplayEvents(Handler &handler) const {
+    handler.HandleBatchStart();
+    std::vector<EdgeId> old_edges;
+    for (const Event &event : event_log_) {
+        const uint64_t *ids = event.ids;
+        switch (event.type) {
+            case EventType::AddVertex:
+                applier_->ApplyAdd(handler, VertexId(ids[0]));
+                break;
+            case EventType::AddEdge:
+                applier_->ApplyAdd(handler, EdgeId(ids[0]));
+                break;
+            case EventType::DeleteVertex:
+                applier_->ApplyDelete(handler, VertexId(ids[0]));
+                break;
+            case EventType::DeleteEdge:
+                applier_->ApplyDelete(handler, EdgeId(ids[0]));
+                break;
+            case EventType::Merge:
+                old_edges.assign(event_edges_.begin() + ids[0], event_edges_.begin() + ids[0] + ids[1]);
+                applier_->ApplyMerge(handler, old_edges, EdgeId(ids[2]));
+                break;
+            case EventType::Glue:
+                applier_->ApplyGlue(handler, EdgeId(ids[0]), EdgeId(ids[1]), EdgeId(ids[2]));
+                break;
+            case EventType::Split:
+                applier_->ApplySplit(handler, EdgeId(ids[0]), EdgeId(ids[1]), EdgeId(ids[2]));
+                break;
+        }
+    }
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FlushEvents() {
+    if (!event_log_.empty()) {
+        TRACE("Flushing " << event_log_.size() << " events to " << batched_handlers_.size() << " handlers");
+        // Graph is not modified during the replay, handlers only touch their own state
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < batched_handlers_.size(); ++i) {
+            if (batched_handlers_[i]->IsAttached())
+                ReplayEvents(*batched_handlers_[i]);
+        }
+        for (Handler *handler : batched_handlers_) {
+            if (handler->IsAttached())
+                handler->HandleBatchEnd();
+        }
+        event_log_.clear();
+        event_edges_.clear();
+    }
+
+    for (EdgeId e : deferred_edges_)
+        base::HiddenDestroyEdge(e);
+    for (VertexId v : deferred_vertices_)
+        base::HiddenDeleteVertex(v);
+    deferred_edges_.clear();
+    deferred_vertices_.clear();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::EndEventBatch() {
+    VERIFY(batch_depth_ > 0);
+    if (--batch_depth_)
+        return;
+
+    FlushEvents();
+
+    // Restore the original order of the handlers, the ones added during the batch go last
+    std::vector<Handler*> handlers;
+    for (Handler *handler : handler_order_) {
+        if (std::find(action_handler_list_.begin(), action_handler_list_.end(), handler) != action_handler_list_.end() ||
+            std::find(batched_handlers_.begin(), batched_handlers_.end(), handler) != batched_handlers_.end())
+            handlers.push_back(handler);
+    }
+    for (Handler *handler : action_handler_list_) {
+        if (std::find(handler_order_.begin(), handler_order_.end(), handler) == handler_order_.end())
+            handlers.push_back(handler);
+    }
+    action_handler_list_ = std::move(handlers);
+    batched_handlers_.clear();
+    handler_order_.clear();
+    TRACE("Event batch finished");
 }
 
 template<class DataMaster>
@@ -413,6 +616,10 @@ void ObservableGraph<DataMaster>::clear() {
 
 template<class DataMaster>
 ObservableGraph<DataMaster>::~ObservableGraph<DataMaster>() {
+    if (batch_depth_) {
+        batch_depth_ = 1;
+        EndEventBatch();
+    }
     FireGameOver();
     clear();
 }
@@ -467,7 +674,11 @@ typename ObservableGraph<DataMaster>::EdgeId
     auto vertices_to_delete = VerticesToDelete(corrected_path);
     FireDeletePath(edges_to_delete, vertices_to_delete);
     FireAddEdge(new_edge);
-    base::HiddenDeletePath(edges_to_delete, vertices_to_delete);
+    for (EdgeId e : edges_to_delete)
+        RemoveEdge(e);
+    for (VertexId v : vertices_to_delete)
+        RemoveVertex(v);
+    MaybeFlushEvents();
     return new_edge;
 }
 
@@ -487,7 +698,8 @@ std::pair<typename ObservableGraph<DataMaster>::EdgeId, typename ObservableGraph
     FireAddVertex(splitVertex);
     FireAddEdge(new_edge1);
     FireAddEdge(new_edge2);
-    base::HiddenDeleteEdge(edge);
+    RemoveEdge(edge);
+    MaybeFlushEvents();
     return {new_edge1, new_edge2};
 }
 
@@ -500,8 +712,8 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
     FireAddEdge(new_edge);
     VertexId start = base::EdgeStart(edge1);
     VertexId end = base::EdgeEnd(edge1);
-    base::HiddenDeleteEdge(edge1);
-    base::HiddenDeleteEdge(edge2);
+    RemoveEdge(edge1);
+    RemoveEdge(edge2);
 
     if (base::IsDeadStart(start) && base::IsDeadEnd(start)) {
         DeleteVertex(start);
@@ -513,4 +725,23 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
     return new_edge;
 }
 
+/**
+ * Keeps the graph in the batched event mode during its lifetime, see ObservableGraph::BeginEventBatch()
+ */
+template<class Graph>
+class EventBatch {
+    Graph &g_;
+public:
+    explicit EventBatch(Graph &g) : g_(g) {
+        g_.BeginEventBatch();
+    }
+
+    EventBatch(const EventBatch&) = delete;
+    EventBatch &operator=(const EventBatch&) = delete;
+
+    ~EventBatch() {
+        g_.EndEventBatch();
+    }
+};
+
 } // namespace omnigraph
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "adt/queue_iterator.hpp"
+
 #include <functional>
 
 namespace omnigraph {
@@ -11,6 +13,9 @@ private:
     typedef typename Graph::VertexId VertexId;
     std::reference_wrapper<const Graph> graph_;
 public:
+    // Smart iterators keep edges in buckets by coverage instead of a single heap
+    typedef adt::quantized_buckets<> buckets_type;
+
     CoverageComparator(const Graph &graph)
             : graph_(graph) {}
 
@@ -43,6 +48,9 @@ struct LengthComparator {
     typedef typename Graph::VertexId VertexId;
     std::reference_wrapper<const Graph> graph_;
   public:
+    // Smart iterators keep edges in buckets by length instead of a single heap
+    typedef adt::integer_buckets<> buckets_type;
+
     LengthComparator(const Graph &graph)
             : graph_(graph) {}
 
@@ -14,6 +14,8 @@
 #include "utils/perf/timetracer.hpp"
 #include "utils/logger/logger.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace omnigraph {
 
 template<class Graph, class ElementId>
@@ -126,6 +128,75 @@ private:
     DECL_LOGGER("ParallelInterestingElementFinder");
 };
 
+/**
+ * Records vertices whose sets of incident edges were changed by graph modifications
+ * together with the removed elements. Used to detect whether the outcome of a check
+ * performed earlier on some element could have been affected by these modifications.
+ */
+template<class Graph>
+class NeighbourhoodChangeTracker : public GraphActionHandler<Graph> {
+    typedef GraphActionHandler<Graph> base;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+
+    phmap::flat_hash_set<VertexId> touched_;
+    phmap::flat_hash_set<VertexId> removed_vertices_;
+    phmap::flat_hash_set<EdgeId> removed_edges_;
+
+    void TouchEnds(EdgeId e) {
+        touched_.insert(this->g().EdgeStart(e));
+        touched_.insert(this->g().EdgeEnd(e));
+    }
+
+public:
+    NeighbourhoodChangeTracker(const Graph &g)
+            : base(g, "NeighbourhoodChangeTracker") {}
+
+    void HandleAdd(VertexId v) override {
+        touched_.insert(v);
+    }
+
+    void HandleAdd(EdgeId e) override {
+        TouchEnds(e);
+    }
+
+    void HandleDelete(VertexId v) override {
+        touched_.insert(v);
+        removed_vertices_.insert(v);
+    }
+
+    void HandleDelete(EdgeId e) override {
+        TouchEnds(e);
+        removed_edges_.insert(e);
+    }
+
+    bool Removed(VertexId v) const {
+        return removed_vertices_.count(v);
+    }
+
+    bool Removed(EdgeId e) const {
+        return removed_edges_.count(e);
+    }
+
+    bool Affected(VertexId v) const {
+        return touched_.count(v);
+    }
+
+    bool Affected(EdgeId e) const {
+        return touched_.count(this->g().EdgeStart(e)) || touched_.count(this->g().EdgeEnd(e));
+    }
+
+    bool empty() const {
+        return touched_.empty();
+    }
+
+    void clear() {
+        touched_.clear();
+        removed_vertices_.clear();
+        removed_edges_.clear();
+    }
+};
+
 template<class Graph>
 class PersistentAlgorithmBase {
     Graph& g_;
@@ -326,6 +397,7 @@ protected:
 private:
     SmartSetIterator<Graph, ElementId, Priority> it_;
     const bool tracking_;
+    size_t batch_size_;
 
 protected:
     void ReturnForConsideration(ElementId el) {
@@ -336,6 +408,18 @@ protected:
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
 
+    /**
+     * Batched mode only. Read-only check whether the element should be processed.
+     * Called concurrently for all elements of the batch, so must be thread-safe.
+     */
+    virtual bool Check(ElementId /*el*/) const { return true; }
+
+    /**
+     * Batched mode only. Processes the element which passed Check. Only called
+     * if no graph modification made after the check touched the element neighbourhood.
+     */
+    virtual bool ProcessChecked(ElementId el) { return Process(el); }
+
 public:
 
     PersistentProcessingAlgorithm(Graph& g,
@@ -346,10 +430,21 @@ public:
             PersistentAlgorithmBase<Graph>(g),
             interest_el_finder_(interest_el_finder),
             it_(g, true, priority, canonical_only),
-            tracking_(track_changes) {
+            tracking_(track_changes),
+            batch_size_(0) {
         it_.Detach();
     }
 
+    /**
+     * Enables batched processing: up to batch_size candidates are taken in the priority
+     * order and checked in parallel, then processed sequentially in the same order.
+     * Candidates which neighbourhood was modified by the preceding actions are returned
+     * to the queue for the next batch. 0 turns batching off.
+     */
+    void set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size;
+    }
+
     size_t Run(bool force_primary_launch = false,
                double iter_run_progress = 1.) override {
         bool primary_launch = force_primary_launch ;
@@ -374,16 +469,20 @@ public:
 
         size_t triggered = 0;
         TRACE("Start processing");
-        for (; !it_.IsEnd(); ++it_) {
-            ElementId el = *it_;
-            if (!Proceed(el)) {
-                TRACE("Proceed condition turned false on element " << this->g().str(el));
-                it_.ReleaseCurrent();
-                break;
+        if (batch_size_ > 1) {
+            triggered = ProcessBatched();
+        } else {
+            for (; !it_.IsEnd(); ++it_) {
+                ElementId el = *it_;
+                if (!Proceed(el)) {
+                    TRACE("Proceed condition turned false on element " << this->g().str(el));
+                    it_.ReleaseCurrent();
+                    break;
+                }
+                TRACE("Processing edge " << this->g().str(el));
+                if (Process(el))
+                    triggered++;
             }
-            TRACE("Processing edge " << this->g().str(el));
-            if (Process(el))
-                triggered++;
         }
         TRACE("Finished processing. Triggered = " << triggered);
         if (!tracking_)
@@ -393,6 +492,58 @@ public:
     }
 
 private:
+    //returns false if proceed condition turned false
+    bool FillBatch(std::vector<ElementId> &batch) {
+        batch.clear();
+        for (; !it_.IsEnd() && batch.size() < batch_size_; ++it_) {
+            ElementId el = *it_;
+            if (!Proceed(el)) {
+                TRACE("Proceed condition turned false on element " << this->g().str(el));
+                it_.ReleaseCurrent();
+                return false;
+            }
+            batch.push_back(el);
+        }
+        return true;
+    }
+
+    size_t ProcessBatched() {
+        NeighbourhoodChangeTracker<Graph> tracker(this->g());
+        std::vector<ElementId> batch, deferred;
+        std::vector<uint8_t> checked;
+        batch.reserve(batch_size_);
+
+        size_t triggered = 0;
+        bool proceed = true;
+        while (proceed && !it_.IsEnd()) {
+            proceed = FillBatch(batch);
+            TRACE("Checking batch of " << batch.size() << " elements");
+            checked.assign(batch.size(), 0);
+            #pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < batch.size(); ++i)
+                checked[i] = Check(batch[i]);
+
+            tracker.clear();
+            deferred.clear();
+            for (size_t i = 0; i < batch.size(); ++i) {
+                ElementId el = batch[i];
+                if (tracker.Removed(el))
+                    continue;
+                if (tracker.Affected(el)) {
+                    deferred.push_back(el);
+                    continue;
+                }
+                if (checked[i] && ProcessChecked(el))
+                    triggered++;
+            }
+
+            TRACE(deferred.size() << " elements deferred to the next batch");
+            for (ElementId el : deferred)
+                it_.push(el);
+        }
+        return triggered;
+    }
+
     DECL_LOGGER("PersistentProcessingAlgorithm"); 
 };
 
@@ -420,6 +571,16 @@ protected:
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    bool ProcessChecked(EdgeId e) override {
+        TRACE("Removing edge " << this->g().str(e));
+        edge_remover_.DeleteEdge(e);
+        return true;
+    }
+
 public:
     ParallelEdgeRemovingAlgorithm(Graph& g,
                                   func::TypedPredicate<EdgeId> remove_condition,
@@ -472,6 +633,15 @@ public:
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return condition_(e);
+    }
+
+    bool ProcessChecked(EdgeId e) override {
+        disconnector_(e);
+        return true;
+    }
+
 };
 
 
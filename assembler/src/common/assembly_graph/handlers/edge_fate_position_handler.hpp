@@ -6,7 +6,7 @@
 #pragma once
 #include "utils/stl_utils.hpp"
 #include "assembly_graph/core/action_handlers.hpp"
-#include <unordered_map>
+#include <parallel_hashmap/phmap.h>
 
 using namespace omnigraph;
 
@@ -17,7 +17,7 @@ class EdgeFatePositionTracker : omnigraph::GraphActionHandler<Graph> {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename std::vector<std::pair<EdgeId, size_t>> OldEdgesInfo;
 
-    std::unordered_map<EdgeId, OldEdgesInfo> storage_;
+    phmap::flat_hash_map<EdgeId, OldEdgesInfo> storage_;
 
     void FillRelevant(EdgeId e, std::set<EdgeId> &relevant) const {
         auto it = storage_.find(e);
@@ -49,10 +49,12 @@ public:
         DEBUG("merging ");
         for (EdgeId e : old_edges) {
             DEBUG(e.int_id());
-            res.insert(res.end(), storage_[e].begin(), storage_[e].end());
+            auto it = storage_.find(e);
+            if (it != storage_.end())
+                res.insert(res.end(), it->second.begin(), it->second.end());
         }
         DEBUG("into " << new_edge.int_id());
-        storage_[new_edge] = res;
+        storage_[new_edge] = std::move(res);
     }
 
     void HandleGlue(EdgeId /*new_edge*/, EdgeId /*edge1*/, EdgeId /*edge2*/) override {
@@ -65,6 +67,7 @@ public:
     }
 
     void Init() {
+        storage_.reserve(this->g().e_size());
         for (EdgeId e: this->g().edges()) {
             storage_[e] = {std::make_pair(e, this->g().length(e))};
         }
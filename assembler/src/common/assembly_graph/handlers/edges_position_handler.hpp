@@ -18,7 +18,14 @@
 #include "utils/stl_utils.hpp"
 #include "assembly_graph/paths/mapping_path.hpp"
 #include "assembly_graph/core/action_handlers.hpp"
-#include <map>
+
+#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace omnigraph {
 
@@ -41,13 +48,38 @@ class EdgesPositionHandler: public GraphActionHandler<Graph> {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
     typedef std::set<MappingRange> RangeSet;
+    // Ranges of an edge on a single contig, kept sorted in RangeSet order
+    typedef std::vector<MappingRange> Ranges;
+    // Positions of an edge: interned contig id and its ranges, sorted by contig name
+    typedef std::vector<std::pair<uint32_t, Ranges>> Positions;
 
     size_t max_mapping_gap_;
     size_t max_gap_diff_;
-    std::map<EdgeId, std::map<std::string, RangeSet>> edges_positions_;
-    //TODO extract RangeSet aka set<MappingRange> as a storage class
+    std::vector<std::string> contig_names_;
+    phmap::flat_hash_map<std::string, uint32_t> contig_ids_;
+    // Node map keeps references to the positions stable while other edges are inserted
+    phmap::node_hash_map<EdgeId, Positions> edges_positions_;
+
+    // Smaller waves of the recorded tasks are applied sequentially
+    static const size_t PARALLEL_WAVE = 64;
 
-    MappingRange EraseAndExtract(RangeSet &ranges, RangeSet::iterator position, const MappingRange &new_pos) const {
+    // Copy of the positions of an edge to another one
+    struct Transfer {
+        EdgeId to;
+        EdgeId from;
+        int shift;
+    };
+
+    // Events of a batch are recorded as tasks (consecutive transfers of a single merge, glue or
+    // split) and applied at the end of the batch, see HandleBatchEnd()
+    bool deferred_;
+    std::vector<Transfer> transfers_;
+    std::vector<size_t> task_ends_;
+    std::vector<EdgeId> deleted_;
+    // Edges which get positions from the recorded tasks
+    phmap::flat_hash_set<EdgeId> pending_;
+
+    MappingRange EraseAndExtract(Ranges &ranges, typename Ranges::iterator position, const MappingRange &new_pos) const {
         auto old_pos = *position;
         if (old_pos.IntersectLeftOf(new_pos) || old_pos.StrictlyContinuesWith(new_pos, max_mapping_gap_, max_gap_diff_)) {
             ranges.erase(position);
@@ -60,18 +92,11 @@ class EdgesPositionHandler: public GraphActionHandler<Graph> {
         }
     }
 
-    std::string RangeStr(const Range &range) const {
-        std::stringstream ss;
-        ss << "[" << (range.start_pos + 1) << " - " << range.end_pos << "]";
-        return ss.str();
-    }
-
-public:
-    MappingRange EraseAndExtract(RangeSet &ranges, MappingRange new_pos) const {
-        auto it = ranges.lower_bound(new_pos);
+    MappingRange EraseAndExtract(Ranges &ranges, MappingRange new_pos) const {
+        auto it = std::lower_bound(ranges.begin(), ranges.end(), new_pos);
         if (it != ranges.end()) {
             new_pos = EraseAndExtract(ranges, it, new_pos);
-            it = ranges.lower_bound(new_pos);
+            it = std::lower_bound(ranges.begin(), ranges.end(), new_pos);
         }
         if (it != ranges.begin()) {
             new_pos = EraseAndExtract(ranges, std::prev(it), new_pos);
@@ -79,23 +104,156 @@ public:
         return new_pos;
     }
 
+    uint32_t ContigId(const std::string &contig_id) {
+        auto it = contig_ids_.find(contig_id);
+        if (it != contig_ids_.end())
+            return it->second;
+
+        uint32_t id = uint32_t(contig_names_.size());
+        contig_names_.push_back(contig_id);
+        contig_ids_.emplace(contig_id, id);
+        return id;
+    }
+
+    const Ranges *FindRanges(EdgeId edge, const std::string &contig_id) const {
+        auto edge_it = edges_positions_.find(edge);
+        auto id_it = contig_ids_.find(contig_id);
+        if (edge_it == edges_positions_.end() || id_it == contig_ids_.end())
+            return nullptr;
+
+        for (const auto &entry : edge_it->second)
+            if (entry.first == id_it->second)
+                return &entry.second;
+        return nullptr;
+    }
+
+    Ranges &GetRanges(EdgeId edge, uint32_t contig) {
+        auto &positions = edges_positions_[edge];
+        const std::string &name = contig_names_[contig];
+        auto it = std::lower_bound(positions.begin(), positions.end(), name,
+                                   [&](const std::pair<uint32_t, Ranges> &entry, const std::string &n) {
+                                       return contig_names_[entry.first] < n;
+                                   });
+        if (it == positions.end() || it->first != contig)
+            it = positions.emplace(it, contig, Ranges());
+        return it->second;
+    }
+
+    void AddEdgePosition(EdgeId edge, uint32_t contig, MappingRange new_pos) {
+        if (new_pos.empty())
+            return;
+        auto &ranges = GetRanges(edge, contig);
+        new_pos = EraseAndExtract(ranges, new_pos);
+        auto it = std::lower_bound(ranges.begin(), ranges.end(), new_pos);
+        if (it == ranges.end() || new_pos < *it)
+            ranges.insert(it, new_pos);
+    }
+
+    void AddAndShiftEdgePositions(EdgeId edge, const Positions &positions, int shift = 0) {
+        for (const auto &contig : positions) {
+            for (const auto &e : contig.second) {
+                AddEdgePosition(edge, contig.first, e.Shift(shift).Fit(this->g().length(edge)));
+            }
+        }
+    }
+
+    void TransferPositions(EdgeId to, EdgeId from, int shift) {
+        if (deferred_) {
+            if (edges_positions_.count(from) || pending_.count(from)) {
+                transfers_.push_back({to, from, shift});
+                pending_.insert(to);
+            }
+            return;
+        }
+
+        auto it = edges_positions_.find(from);
+        if (it != edges_positions_.end())
+            AddAndShiftEdgePositions(to, it->second, shift);
+    }
+
+    void EndTask() {
+        if (deferred_ && transfers_.size() > (task_ends_.empty() ? 0 : task_ends_.back()))
+            task_ends_.push_back(transfers_.size());
+    }
+
+    void ApplyTask(size_t task) {
+        for (size_t i = task ? task_ends_[task - 1] : 0; i < task_ends_[task]; ++i) {
+            const auto &t = transfers_[i];
+            auto it = edges_positions_.find(t.from);
+            if (it != edges_positions_.end())
+                AddAndShiftEdgePositions(t.to, it->second, t.shift);
+        }
+    }
+
+    // Applies the recorded tasks in waves: a task goes after the tasks writing the edges it touches
+    // and after the tasks reading the edges it writes, so the tasks of a wave are independent
+    void ApplyTasks() {
+        phmap::flat_hash_map<EdgeId, std::pair<size_t, size_t>> last_wave; // (write, read)
+        std::vector<size_t> waves(task_ends_.size());
+        size_t wave_cnt = 0;
+        for (size_t task = 0, i = 0; task < task_ends_.size(); ++task) {
+            size_t begin = i, wave = 0;
+            for (; i < task_ends_[task]; ++i) {
+                const auto &t = transfers_[i];
+                wave = std::max(wave, last_wave[t.from].first + 1);
+                const auto &to = last_wave[t.to];
+                wave = std::max(wave, std::max(to.first, to.second) + 1);
+            }
+            for (i = begin; i < task_ends_[task]; ++i) {
+                auto &from = last_wave[transfers_[i].from];
+                from.second = std::max(from.second, wave);
+                last_wave[transfers_[i].to].first = wave;
+            }
+            waves[task] = wave - 1;
+            wave_cnt = std::max(wave_cnt, wave);
+        }
+
+        std::vector<size_t> wave_begins(wave_cnt + 1, 0), tasks(task_ends_.size());
+        for (size_t wave : waves)
+            wave_begins[wave + 1] += 1;
+        std::partial_sum(wave_begins.begin(), wave_begins.end(), wave_begins.begin());
+        std::vector<size_t> wave_ends(wave_begins.begin(), wave_begins.end() - 1);
+        for (size_t task = 0; task < waves.size(); ++task)
+            tasks[wave_ends[waves[task]]++] = task;
+
+        // Tasks only look the edges up, so the entries are created in advance
+        for (EdgeId e : pending_)
+            edges_positions_[e];
+
+        for (size_t wave = 0; wave < wave_cnt; ++wave) {
+            size_t begin = wave_begins[wave], end = wave_begins[wave + 1];
+#           pragma omp parallel for schedule(guided) if (end - begin >= PARALLEL_WAVE)
+            for (size_t i = begin; i < end; ++i)
+                ApplyTask(tasks[i]);
+        }
+
+        for (EdgeId e : pending_) {
+            auto it = edges_positions_.find(e);
+            if (it->second.empty())
+                edges_positions_.erase(it);
+        }
+    }
+
+    std::string RangeStr(const Range &range) const {
+        std::stringstream ss;
+        ss << "[" << (range.start_pos + 1) << " - " << range.end_pos << "]";
+        return ss.str();
+    }
+
+public:
     RangeSet GetEdgePositions(EdgeId edge, const std::string &contig_id) const {
         VERIFY(this->IsAttached());
-        auto edge_it = edges_positions_.find(edge);
-        if (edge_it == edges_positions_.end())
-            return {};
-        const auto &positions = edge_it->second;
-        auto it = positions.find(contig_id);
-        if (it == positions.end())
+        const Ranges *ranges = FindRanges(edge, contig_id);
+        if (!ranges)
             return {};
-        else
-            return it->second;
+        return RangeSet(ranges->begin(), ranges->end());
     }
 
     MappingRange GetUniqueEdgePosition(EdgeId edge, const std::string &contig_id) const {
-        auto poss = GetEdgePositions(edge, contig_id);
-        VERIFY(poss.size() == 1);
-        return *poss.begin();
+        VERIFY(this->IsAttached());
+        const Ranges *ranges = FindRanges(edge, contig_id);
+        VERIFY(ranges && ranges->size() == 1);
+        return ranges->front();
     }
 
     std::vector<EdgePosition> GetEdgePositions(EdgeId edge) const {
@@ -106,12 +264,23 @@ public:
         std::vector<EdgePosition> result;
         for (const auto &i : edge_it->second) {
             for (const auto &pos : i.second) {
-                result.push_back(EdgePosition(i.first, pos));
+                result.push_back(EdgePosition(contig_names_[i.first], pos));
             }
         }
         return result;
     }
 
+    bool HasPositions(EdgeId edge) const {
+        VERIFY(this->IsAttached());
+        auto edge_it = edges_positions_.find(edge);
+        if (edge_it == edges_positions_.end())
+            return false;
+        for (const auto &i : edge_it->second)
+            if (!i.second.empty())
+                return true;
+        return false;
+    }
+
     void AddEdgePosition(EdgeId edge, const std::string &contig_id, size_t start, size_t end, size_t m_start, size_t m_end) {
         VERIFY(this->IsAttached());
         AddEdgePosition(edge, contig_id, MappingRange(start, end, m_start, m_end));
@@ -121,18 +290,7 @@ public:
         VERIFY(this->IsAttached());
         if (new_pos.empty())
             return;
-        auto &new_set = edges_positions_[edge][contig_id];
-        new_pos = EraseAndExtract(new_set, new_pos);
-        new_set.insert(new_pos);
-    }
-
-    void AddAndShiftEdgePositions(EdgeId edge, const std::map<std::string, RangeSet> &contig_map, int shift = 0) {
-        VERIFY(this->IsAttached());
-        for (const auto &contig : contig_map) {
-            for (const auto &e : contig.second) {
-                AddEdgePosition(edge, contig.first, e.Shift(shift).Fit(this->g().length(edge)));
-            }
-        }
+        AddEdgePosition(edge, ContigId(contig_id), new_pos);
     }
 
     template<typename Iter>
@@ -170,7 +328,8 @@ public:
     EdgesPositionHandler(const Graph &g, size_t max_mapping_gap, size_t max_gap_diff = 0) :
             GraphActionHandler<Graph>(g, "EdgePositionHandler"), 
             max_mapping_gap_(max_mapping_gap),
-            max_gap_diff_(max_gap_diff) {
+            max_gap_diff_(max_gap_diff),
+            deferred_(false) {
     }
 
     virtual ~EdgesPositionHandler() {
@@ -179,10 +338,9 @@ public:
 
     virtual void HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
 //        TRACE("Handle glue ");
-        auto positions1 = GetEdgePositions(edge1);
-        auto positions2 = GetEdgePositions(edge2);
-        AddEdgePositions(new_edge, positions1.begin(), positions1.end());
-        AddEdgePositions(new_edge, positions2.begin(), positions2.end());
+        for (EdgeId e : { edge1, edge2 })
+            TransferPositions(new_edge, e, 0);
+        EndTask();
     }
 
     virtual void HandleSplit(EdgeId oldEdge, EdgeId newEdge1, EdgeId newEdge2) {
@@ -190,32 +348,59 @@ public:
             WARN("EdgesPositionHandler does not support self-conjugate splits");
             return;
         }
-        if (edges_positions_.count(oldEdge) != 0) {
-            auto contig_map = edges_positions_[oldEdge];
-            AddAndShiftEdgePositions(newEdge1, contig_map, 0);
-            AddAndShiftEdgePositions(newEdge2, contig_map, -int(this->g().length(newEdge1)));
-        }
+        TransferPositions(newEdge1, oldEdge, 0);
+        TransferPositions(newEdge2, oldEdge, -int(this->g().length(newEdge1)));
+        EndTask();
     }
 
     virtual void HandleMerge(const std::vector<EdgeId> &oldEdges, EdgeId newEdge) {
         int shift = 0;
         for (const auto &e : oldEdges) {
-            if (edges_positions_.count(e)) {
-                AddAndShiftEdgePositions(newEdge, edges_positions_[e], shift);
-            }
+            TransferPositions(newEdge, e, shift);
             shift += int(this->g().length(e));
         }
+        EndTask();
     }
 
     virtual void HandleAdd(EdgeId /*e*/) {
     }
 
     virtual void HandleDelete(EdgeId e) {
-        edges_positions_.erase(e);
+        // Ids of the removed edges are not reused until the end of the batch
+        if (deferred_)
+            deleted_.push_back(e);
+        else
+            edges_positions_.erase(e);
+    }
+
+    bool IsBatchable() const override {
+        return true;
+    }
+
+    void HandleBatchStart() override {
+        deferred_ = true;
+    }
+
+    void HandleBatchEnd() override {
+        if (!deferred_)
+            return;
+
+        if (!task_ends_.empty())
+            ApplyTasks();
+        for (EdgeId e : deleted_)
+            edges_positions_.erase(e);
+
+        deferred_ = false;
+        std::vector<Transfer>().swap(transfers_);
+        std::vector<size_t>().swap(task_ends_);
+        std::vector<EdgeId>().swap(deleted_);
+        phmap::flat_hash_set<EdgeId>().swap(pending_);
     }
 
     void clear() {
         edges_positions_.clear();
+        contig_ids_.clear();
+        contig_names_.clear();
     }
 
 private:
@@ -11,7 +11,7 @@
 #include "utils/stl_utils.hpp"
 #include "assembly_graph/core/action_handlers.hpp"
 
-#include <unordered_map>
+#include <parallel_hashmap/phmap.h>
 
 namespace omnigraph {
 
@@ -19,8 +19,8 @@ template<class Graph>
 class GraphElementFinder : public GraphActionHandler<Graph> {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
-    std::unordered_map<size_t, VertexId> id2vertex_;
-    std::unordered_map<size_t, EdgeId> id2edge_;
+    phmap::flat_hash_map<size_t, VertexId> id2vertex_;
+    phmap::flat_hash_map<size_t, EdgeId> id2edge_;
 
 public:
     explicit GraphElementFinder(const Graph &graph) :
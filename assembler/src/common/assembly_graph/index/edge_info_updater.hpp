@@ -14,6 +14,9 @@
 
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace debruijn_graph {
 
 template<typename Graph>
@@ -35,14 +38,32 @@ class EdgeInfoUpdater {
     template<class Index>
     void UpdateKMers(const Sequence &nucls, EdgeId e, Index &index) {
         VERIFY(nucls.size() >= index.k());
-        typename Index::KeyWithHash kwh = index.ConstructKWH(typename Index::KMer(index.k(), nucls));
-        if (kwh.is_minimal())
-            index.PutInIndex(kwh, e, 0);
+        typedef typename Index::KMer KMer;
+        typedef typename Index::KeyWithHash KeyWithHash;
+
+        // K-mers are looked up in batches to overlap the index cache misses
+        const size_t batch = 256;
+        std::vector<KMer> kmers;
+        kmers.reserve(std::min(batch, nucls.size() - index.k() + 1));
+        size_t offset = 0;
+        auto flush = [&]() {
+            index.ConstructKWHs(kmers.data(), kmers.size(), [&](size_t i, KeyWithHash kwh) {
+                if (kwh.is_minimal())
+                    index.PutInIndex(kwh, e, offset + i);
+            });
+            offset += kmers.size();
+            kmers.clear();
+        };
+
+        KMer kmer(index.k(), nucls);
+        kmers.push_back(kmer);
         for (size_t i = index.k(), n = nucls.size(); i < n; ++i) {
-            kwh <<= nucls[i];
-            if (kwh.is_minimal())
-                index.PutInIndex(kwh, e, i - index.k() + 1);
+            kmer <<= nucls[i];
+            kmers.push_back(kmer);
+            if (kmers.size() == batch)
+                flush();
         }
+        flush();
     }
 
     template<class Index>
@@ -7,8 +7,11 @@
 #pragma once
 
 #include "io_base.hpp"
+#include "assembly_graph/core/graph_fingerprint.hpp"
 #include "modules/alignment/edge_index.hpp"
 
+#include <cstdio>
+
 namespace io {
 
 namespace binary {
@@ -32,6 +35,67 @@ public:
         value.clear();
         str >> value;
     }
+
+    /**
+     * @brief  Saves the index to be reused by later standalone runs on the same
+     *         graph. Unlike the .kmidx in the saves, the snapshot carries the format
+     *         version and the fingerprint of the graph it was built for.
+     */
+    void SaveSnapshot(const std::string &basename, const Type &value) {
+        std::string filename = basename + ".kmsnap";
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            WARN("Cannot save edge index snapshot into " << filename);
+            return;
+        }
+        INFO("Saving edge index snapshot into " << filename);
+        SnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION,
+                                  omnigraph::GraphFingerprint(value.g()) };
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        BinOStream writer(file);
+        SaveImpl(writer, value);
+        if (!file) {
+            WARN("Failed to write edge index snapshot " << filename);
+            file.close();
+            std::remove(filename.c_str());
+        }
+    }
+
+    /**
+     * @return false if the snapshot is missing, has another format version or
+     *         was built for another graph.
+     */
+    bool LoadSnapshot(const std::string &basename, Type &value) {
+        std::string filename = basename + ".kmsnap";
+        if (!fs::check_existence(filename))
+            return false;
+        auto file = fs::open_file(filename, std::ios::binary);
+        SnapshotHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!file || header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+            INFO("Edge index snapshot " << filename << " has unsupported format, ignoring");
+            return false;
+        }
+        if (header.fingerprint != omnigraph::GraphFingerprint(value.g())) {
+            INFO("Edge index snapshot " << filename << " does not match the graph, ignoring");
+            return false;
+        }
+        BinIStream reader(file);
+        INFO("Loading edge index snapshot from " << filename);
+        LoadImpl(reader, value);
+        return true;
+    }
+
+private:
+    // Written as is: the fingerprint is a full 64-bit hash, ULEB128 does not suit it
+    struct SnapshotHeader {
+        uint64_t magic;
+        uint64_t version;
+        uint64_t fingerprint;
+    };
+
+    static const uint64_t SNAPSHOT_MAGIC = 0x50414e534d4b4553ULL; // "SEKMSNAP"
+    static const uint64_t SNAPSHOT_VERSION = 2;
 };
 
 template<typename Graph>
@@ -0,0 +1,195 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io_base.hpp"
+
+#include "assembly_graph/core/graph.hpp"
+#include "sequence/sequence.hpp"
+#include "utils/verify.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace io {
+
+namespace binary {
+
+namespace impl {
+
+/**
+ * @brief  Read-only memory mapping of the whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        CHECK_FATAL_ERROR(fd != -1, "open(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+        struct stat st;
+        CHECK_FATAL_ERROR(fstat(fd, &st) == 0, "fstat(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+        size_ = st.st_size;
+        // MAP_SHARED so that concurrent processes loading the same graph share page cache
+        addr_ = size_ ? mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+        close(fd);
+        CHECK_FATAL_ERROR(addr_ != MAP_FAILED, "mmap(2) failed. Reason: " << strerror(errno) << ". File: " << filename);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (addr_)
+            munmap(addr_, size_);
+    }
+
+    const uint8_t *data() const { return static_cast<const uint8_t*>(addr_); }
+    size_t size() const { return size_; }
+
+private:
+    void *addr_;
+    size_t size_;
+};
+
+}
+
+/**
+ * @brief  This IOer processes the graph with its coverage in a memory-mappable layout:
+ *         fixed-width vertex and edge tables plus the packed edge sequences stored
+ *         contiguously. On load the edge sequences are not copied but reference the
+ *         mapping directly, so loading is proportional to the graph topology only.
+ *
+ *         File layout (all fields are uint64_t):
+ *           header: magic, version, vreserved, ereserved, #vertices, #edges, edge table offset
+ *           vertex table: (id, conjugate id) for every vertex
+ *           sequences: Sequence::BinWrite() blobs of the canonical edges
+ *           edge table: (id, conjugate id, start, end, raw coverage, sequence offset)
+ *                       for every canonical edge
+ */
+template<typename Graph>
+class MappedGraphIO : public IOBase<Graph> {
+    static const uint64_t MAGIC = 0x50414d4752534553ULL; // "SESRGMAP"
+    static const uint64_t VERSION = 1;
+    static const size_t HEADER_SIZE = 7;
+    static const size_t EDGE_RECORD_SIZE = 6;
+
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    static void Put(std::ostream &os, uint64_t value) {
+        os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+public:
+    void Save(const std::string &basename, const Graph &graph) override {
+        SaveFile(basename + ".grmap", graph);
+    }
+
+    bool Load(const std::string &basename, Graph &graph) override {
+        return LoadFile(basename + ".grmap", graph);
+    }
+
+    void SaveFile(const std::string &filename, const Graph &graph) {
+        std::ofstream os(filename, std::ios::binary);
+        CHECK_FATAL_ERROR(os, "Failed to open " << filename);
+        DEBUG("Saving mapped graph into " << filename);
+
+        Put(os, MAGIC); Put(os, VERSION);
+        Put(os, graph.vreserved()); Put(os, graph.ereserved());
+        Put(os, graph.size());
+        // Edge count and edge table offset, patched below
+        Put(os, 0); Put(os, 0);
+
+        for (VertexId v : graph) {
+            Put(os, v.int_id());
+            Put(os, graph.conjugate(v).int_id());
+        }
+
+        std::vector<uint64_t> offsets;
+        for (EdgeId e : graph.canonical_edges()) {
+            offsets.push_back(os.tellp());
+            graph.EdgeNucls(e).BinWrite(os);
+        }
+
+        uint64_t edges_offset = os.tellp();
+        size_t i = 0;
+        for (EdgeId e : graph.canonical_edges()) {
+            Put(os, e.int_id()); Put(os, graph.conjugate(e).int_id());
+            Put(os, graph.EdgeStart(e).int_id()); Put(os, graph.EdgeEnd(e).int_id());
+            Put(os, graph.coverage_index().RawCoverage(e));
+            Put(os, offsets[i++]);
+        }
+
+        os.seekp((HEADER_SIZE - 2) * sizeof(uint64_t));
+        Put(os, offsets.size()); Put(os, edges_offset);
+        CHECK_FATAL_ERROR(os, "Failed to write " << filename);
+    }
+
+    bool LoadFile(const std::string &filename, Graph &graph) {
+        if (!fs::check_existence(filename))
+            return false;
+        DEBUG("Loading mapped graph from " << filename);
+
+        auto file = std::make_shared<impl::MappedFile>(filename);
+        const uint8_t *base = file->data();
+        CHECK_FATAL_ERROR(file->size() >= HEADER_SIZE * sizeof(uint64_t), "Truncated mapped graph " << filename);
+        const uint64_t *header = reinterpret_cast<const uint64_t*>(base);
+        CHECK_FATAL_ERROR(header[0] == MAGIC && header[1] == VERSION, "Invalid mapped graph " << filename);
+
+        uint64_t vertex_cnt = header[4], edge_cnt = header[5], edges_offset = header[6];
+        CHECK_FATAL_ERROR(edges_offset + edge_cnt * EDGE_RECORD_SIZE * sizeof(uint64_t) <= file->size(),
+                          "Truncated mapped graph " << filename);
+
+        graph.clear();
+        graph.reserve(header[2], header[3]);
+
+        const uint64_t *vertices = header + HEADER_SIZE;
+        for (size_t i = 0; i < vertex_cnt; ++i) {
+            uint64_t id = vertices[2 * i], conj = vertices[2 * i + 1];
+            if (graph.contains(VertexId(id)))
+                continue;
+            VertexId new_id = graph.AddVertex(typename Graph::VertexData(), id, conj);
+            VERIFY(new_id == id);
+            VERIFY(graph.conjugate(new_id) == conj);
+            (void)new_id;
+        }
+
+        std::shared_ptr<const void> owner = file;
+        const uint64_t *edges = reinterpret_cast<const uint64_t*>(base + edges_offset);
+        for (size_t i = 0; i < edge_cnt; ++i) {
+            const uint64_t *rec = edges + i * EDGE_RECORD_SIZE;
+            const uint64_t *seq = reinterpret_cast<const uint64_t*>(base + rec[5]);
+            // See Sequence::BinWrite(): the size is followed by the packed nucleotides
+            Sequence nucls = Sequence::FromExternal(seq + 1, seq[0], owner);
+
+            EdgeId e = graph.AddEdge(VertexId(rec[2]), VertexId(rec[3]),
+                                     typename Graph::EdgeData(nucls), rec[0], rec[1]);
+            VERIFY(e == rec[0]);
+            unsigned cov = unsigned(rec[4]);
+            graph.coverage_index().SetRawCoverage(e, cov);
+            if (graph.conjugate(e) != e)
+                graph.coverage_index().SetRawCoverage(graph.conjugate(e), cov);
+        }
+
+        return true;
+    }
+
+private:
+    DECL_LOGGER("BinaryIO");
+};
+
+} // namespace binary
+
+} // namespace io
@@ -10,13 +10,13 @@
 #include "assembly_graph/core/construction_helper.hpp"
 
 #include "io/utils/id_mapper.hpp"
+#include "adt/concurrent_dsu.hpp"
 
 #include "gfa1/gfa.h"
 
 #include <string>
 #include <memory>
 #include <vector>
-#include <unordered_set>
 
 using namespace debruijn_graph;
 
@@ -54,82 +54,80 @@ unsigned GFAReader::k() const {
 void GFAReader::to_graph(ConjugateDeBruijnGraph &g,
                          io::IdMapper<std::string> *id_mapper) {
     auto helper = g.GetConstructionHelper();
+    uint32_t n_seg = gfa_->n_seg;
 
     // INFO("Loading segments");
-    std::vector<EdgeId> edges;
-    edges.reserve(gfa_->n_seg);
-    g.ereserve(2 * gfa_->n_seg);
-    for (size_t i = 0; i < gfa_->n_seg; ++i) {
+    // Segment i gets ids min_id + 2*i (and the next one for its conjugate),
+    // so edges could be created (and their sequences packed) in parallel
+    std::vector<EdgeId> edges(n_seg);
+    uint64_t min_id = g.min_id();
+    g.ereserve(2 * n_seg);
+#   pragma omp parallel for schedule(guided)
+    for (uint32_t i = 0; i < n_seg; ++i) {
         gfa_seg_t *seg = gfa_->seg + i;
 
         uint8_t *kc = gfa_aux_get(seg->aux.l_aux, seg->aux.aux, "KC");
         unsigned cov = 0;
         if (kc && kc[0] == 'i')
             cov = *(int32_t*)(kc+1);
-        DeBruijnEdgeData edata(Sequence(seg->seq));
-        EdgeId e = helper.AddEdge(edata);
+        EdgeId e = helper.AddEdge(DeBruijnEdgeData(Sequence(seg->seq)), min_id + 2 * i);
         g.coverage_index().SetRawCoverage(e, cov);
         g.coverage_index().SetRawCoverage(g.conjugate(e), cov);
+        edges[i] = e;
+    }
 
-        if (id_mapper) {
-            (*id_mapper)[e.int_id()] = seg->name;
+    if (id_mapper) {
+        for (uint32_t i = 0; i < n_seg; ++i) {
+            EdgeId e = edges[i];
+            (*id_mapper)[e.int_id()] = gfa_->seg[i].name;
             if (e != g.conjugate(e)) {
-                (*id_mapper)[g.conjugate(e).int_id()] = std::string(seg->name) + '\'';
+                (*id_mapper)[g.conjugate(e).int_id()] = std::string(gfa_->seg[i].name) + '\'';
             }
         }
-        edges.push_back(e);
     }
 
-    // INFO("Creating vertices");
-    g.vreserve(gfa_->n_seg * 4);
-    std::unordered_set<VertexId> vertices;
-    for (uint32_t i = 0; i < gfa_->n_seg; ++i) {
-        VertexId v1 = helper.CreateVertex(DeBruijnVertexData());
-        helper.LinkIncomingEdge(v1, edges[i]);
-        vertices.insert(v1);
-
-        if (edges[i] != g.conjugate(edges[i])) {
-            VertexId v2 = helper.CreateVertex(DeBruijnVertexData());
-            helper.LinkIncomingEdge(v2, g.conjugate(edges[i]));
-            vertices.insert(v2);
+    // INFO("Resolving links");
+    // Edge ends are numbered the same way as GFA segment sides (i << 1 | rc),
+    // the end of the self-conjugate edge has a single number. Each end
+    // contributes two DSU elements: its vertex and the conjugate one.
+    auto edge_end = [&](uint32_t v) {
+        return edges[v >> 1] == g.conjugate(edges[v >> 1]) ? v & ~1u : v;
+    };
+    auto edge_by_side = [&](uint32_t v) {
+        return (v & 1) ? g.conjugate(edges[v >> 1]) : edges[v >> 1];
+    };
+    dsu::ConcurrentDSU uf(4 * size_t(n_seg));
+#   pragma omp parallel for schedule(guided)
+    for (uint32_t v = 0; v < 2 * n_seg; ++v) {
+        gfa_arc_t *av = gfa_arc_a(gfa_.get(), v);
+        for (size_t j = 0; j < gfa_arc_n(gfa_.get(), v); ++j) {
+            // End of the first edge is the start of the second one, that is
+            // the conjugate of the end of its conjugate
+            size_t end1 = edge_end(v), end2 = edge_end(av[j].w ^ 1);
+            uf.unite(2 * end1, 2 * end2 + 1);
+            uf.unite(2 * end1 + 1, 2 * end2);
         }
     }
 
-    // INFO("Linking edges");
-    for (uint32_t i = 0; i < gfa_->n_seg; ++i) {
-        EdgeId e1 = edges[i];
-        // Process direct links
-        {
-            uint32_t vv = i << 1 | 0;
-            gfa_arc_t *av = gfa_arc_a(gfa_.get(), vv);
-            for (size_t j = 0; j < gfa_arc_n(gfa_.get(), vv); ++j) {
-                EdgeId e2 = edges[av[j].w >> 1];
-                if (av[j].w & 1)
-                    e2 = g.conjugate(e2);
-                helper.LinkEdges(e1, e2);
-            }
-        }
-
-        // Process rc links
-        {
-            e1 = g.conjugate(e1);
-            uint32_t vv = i << 1 | 1;
-            gfa_arc_t *av = gfa_arc_a(gfa_.get(), vv);
-            for (size_t j = 0; j < gfa_arc_n(gfa_.get(), vv); ++j) {
-                EdgeId e2 = edges[av[j].w >> 1];
-                if (av[j].w & 1)
-                    e2 = g.conjugate(e2);
-                helper.LinkEdges(e1, e2);
-            }
-        }
-    }
-
-    // INFO("Filtering dangling vertices");
-    for (VertexId v : vertices) {
-        if (g.OutgoingEdgeCount(v) > 0 || g.IncomingEdgeCount(v) > 0)
+    // INFO("Creating vertices");
+    // Sets come in conjugate pairs, a vertex pair is created for each and
+    // then the edges are linked in (sequentially, as linking touches the
+    // adjacency lists of shared vertices)
+    g.vreserve(n_seg * 4);
+    std::vector<VertexId> vertices(4 * size_t(n_seg));
+    for (uint32_t v = 0; v < 2 * n_seg; ++v) {
+        if (edge_end(v) != v)
             continue;
 
-        g.DeleteVertex(v);
+        size_t set = uf.find_set(2 * v), conj_set = uf.find_set(2 * v + 1);
+        CHECK_FATAL_ERROR(set != conj_set, "Vertex at the end of segment " << gfa_->seg[v >> 1].name
+                          << " is conjugate to itself");
+        if (!vertices[set]) {
+            VertexId vertex = helper.CreateVertex(DeBruijnVertexData());
+            vertices[set] = vertex;
+            vertices[conj_set] = g.conjugate(vertex);
+        }
+        helper.LinkIncomingEdge(vertices[set], edge_by_side(v));
     }
 
     // INFO("Reading paths")
@@ -12,7 +12,9 @@
 #include "paired_read.hpp"
 #include "header_naming.hpp"
 #include "common/pipeline/library_fwd.hpp"
+#include "common/io/utils/buffered_ofstream.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -22,14 +24,15 @@ namespace io {
 inline void WriteWrapped(const std::string &s, std::ostream &os, size_t max_width = 60) {
     size_t cur = 0;
     while (cur < s.size()) {
-        os << s.substr(cur, max_width) << "\n";
+        size_t len = std::min(max_width, s.size() - cur);
+        os.write(s.data() + cur, (std::streamsize)len) << '\n';
         cur += max_width;
     }
 }
 
 class osequencestream {
 protected:
-    std::ofstream ofstream_;
+    buffered_ofstream ofstream_;
     size_t id_;
 
     void write_str(const std::string& s) {
@@ -38,7 +41,7 @@ protected:
 
     virtual void write_header(const std::string& s) {
         // Velvet format: NODE_1_length_24705_cov_358.255249
-        ofstream_ << ">" << MakeContigId(id_++, s.size()) << std::endl;
+        ofstream_ << ">" << MakeContigId(id_++, s.size()) << '\n';
     }
 
 public:
@@ -67,7 +70,7 @@ protected:
 
     void write_header(const std::string& s) override {
         // Velvet format: NODE_1_length_24705_cov_358.255249
-        ofstream_ << ">" << MakeContigId(id_++, s.size(), coverage_) << std::endl;
+        ofstream_ << ">" << MakeContigId(id_++, s.size(), coverage_) << '\n';
     }
 
 public:
@@ -91,7 +94,7 @@ protected:
 
     virtual void write_header(const std::string& s) {
         // Velvet format: NODE_1_length_24705_cov_358.255249
-        ofstream_ << ">" << AddClusterId(MakeContigId(id_++, s.size()), cluster_, candidate_, domains_) << std::endl;
+        ofstream_ << ">" << AddClusterId(MakeContigId(id_++, s.size()), cluster_, candidate_, domains_) << '\n';
     }
 
 
@@ -117,10 +120,10 @@ struct FastaWriter {
 
 struct FastqWriter {
     static void Write(std::ostream &stream, const SingleRead &read) {
-        stream << "@" << read.name() << std::endl
-               << read.GetSequenceString() << std::endl
-               << "+" << std::endl
-               << read.GetPhredQualityString() << std::endl;
+        stream << "@" << read.name() << '\n'
+               << read.GetSequenceString() << '\n'
+               << "+\n"
+               << read.GetPhredQualityString() << '\n';
     }
 };
 
@@ -146,8 +149,8 @@ private:
     Stream stream_;
 };
 
-typedef OReadStream<std::ofstream, FastaWriter> OFastaReadStream;
-typedef OReadStream<std::ofstream, FastqWriter> OFastqReadStream;
+typedef OReadStream<buffered_ofstream, FastaWriter> OFastaReadStream;
+typedef OReadStream<buffered_ofstream, FastqWriter> OFastqReadStream;
 
 template<typename Stream, typename Writer>
 class OPairedReadStream {
@@ -176,7 +179,7 @@ private:
     bool rc1_, rc2_;
 };
 
-typedef OPairedReadStream<std::ofstream, FastaWriter> OFastaPairedStream;
-typedef OPairedReadStream<std::ofstream, FastqWriter> OFastqPairedStream;
+typedef OPairedReadStream<buffered_ofstream, FastaWriter> OFastaPairedStream;
+typedef OPairedReadStream<buffered_ofstream, FastqWriter> OFastqPairedStream;
 
 }
@@ -0,0 +1,41 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace io {
+
+// std::ofstream with a large user-space buffer, so writing many small records
+// (reads, contigs, GFA lines) does not end up in a syscall every few kilobytes.
+// Note that std::endl still flushes, use '\n' instead.
+class buffered_ofstream : public std::ofstream {
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 4 << 20;
+
+    explicit buffered_ofstream(const std::string &filename,
+                               std::ios_base::openmode mode = std::ios_base::out,
+                               size_t buffer_size = DEFAULT_BUFFER_SIZE)
+            : buffer_(new char[buffer_size]) {
+        // Buffer has to be installed before the file is opened
+        rdbuf()->pubsetbuf(buffer_.get(), (std::streamsize)buffer_size);
+        open(filename, mode);
+    }
+
+    ~buffered_ofstream() {
+        // Flush while the buffer is still alive
+        if (is_open())
+            close();
+    }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+};
+
+}
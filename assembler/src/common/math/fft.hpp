@@ -0,0 +1,148 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace math {
+
+/**
+ * @brief  Radix-2 FFT of a real sequence of length n = 2^lg_n computed via the complex
+ *         FFT of length n / 2. Twiddles and the bit reversal permutation are precomputed
+ *         once, the transform works on split real / imaginary arrays kept between calls.
+ *         Instances are not thread-safe, ForThread() gives the one of the calling thread.
+ */
+class RealFFT {
+public:
+    typedef std::complex<double> complex_t;
+
+    explicit RealFFT(unsigned lg_n)
+            : n_(size_t(1) << lg_n), half_(std::max<size_t>(n_ / 2, 1)),
+              rev_(half_), cos_(half_ / 2), sin_(half_ / 2),
+              wcos_(half_ + 1), wsin_(half_ + 1),
+              re_(half_), im_(half_), spectrum_(half_ + 1) {
+        VERIFY(lg_n > 0);
+        unsigned lg_half = lg_n - 1;
+        for (size_t i = 0; i < half_; ++i) {
+            size_t r = 0;
+            for (unsigned b = 0; b < lg_half; ++b)
+                if (i & (size_t(1) << b))
+                    r |= size_t(1) << (lg_half - 1 - b);
+            rev_[i] = uint32_t(r);
+        }
+        for (size_t j = 0; j < half_ / 2; ++j) {
+            double ang = 2 * M_PI * double(j) / double(half_);
+            cos_[j] = std::cos(ang);
+            sin_[j] = std::sin(ang);
+        }
+        for (size_t k = 0; k <= half_; ++k) {
+            double ang = 2 * M_PI * double(k) / double(n_);
+            wcos_[k] = std::cos(ang);
+            wsin_[k] = std::sin(ang);
+        }
+    }
+
+    size_t size() const { return n_; }
+
+    // Bins 0..n/2 of the last computed spectrum, the rest follow from the hermitian symmetry
+    std::vector<complex_t> &spectrum() { return spectrum_; }
+    const std::vector<complex_t> &spectrum() const { return spectrum_; }
+
+    // Computes spectrum() of x[0..n)
+    void Forward(const double *x) {
+        for (size_t m = 0; m < half_; ++m) {
+            re_[m] = x[2 * m];
+            im_[m] = x[2 * m + 1];
+        }
+        Transform(false);
+
+        for (size_t k = 0; k <= half_; ++k) {
+            size_t i = k % half_, j = (half_ - k) % half_;
+            // E = (Z[k] + conj(Z[N - k])) / 2, O = (Z[k] - conj(Z[N - k])) / 2i
+            double er = .5 * (re_[i] + re_[j]), ei = .5 * (im_[i] - im_[j]);
+            double or_ = .5 * (im_[i] + im_[j]), oi = -.5 * (re_[i] - re_[j]);
+            // X[k] = E + exp(-2 pi i k / n) * O
+            double wr = wcos_[k], wi = -wsin_[k];
+            spectrum_[k] = complex_t(er + wr * or_ - wi * oi, ei + wr * oi + wi * or_);
+        }
+    }
+
+    // Inverse of Forward() including the 1/n normalization, reads spectrum() and writes x[0..n)
+    void Inverse(double *x) {
+        for (size_t k = 0; k < half_; ++k) {
+            const complex_t &a = spectrum_[k], &b = spectrum_[half_ - k];
+            // E = (X[k] + conj(X[N - k])) / 2, O = (X[k] - conj(X[N - k])) * exp(2 pi i k / n) / 2
+            double er = .5 * (a.real() + b.real()), ei = .5 * (a.imag() - b.imag());
+            double dr = .5 * (a.real() - b.real()), di = .5 * (a.imag() + b.imag());
+            double wr = wcos_[k], wi = wsin_[k];
+            double or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+            // Z = E + i * O
+            re_[k] = er - oi;
+            im_[k] = ei + or_;
+        }
+        Transform(true);
+
+        double norm = 1. / double(half_);
+        for (size_t m = 0; m < half_; ++m) {
+            x[2 * m] = re_[m] * norm;
+            x[2 * m + 1] = im_[m] * norm;
+        }
+    }
+
+    static RealFFT &ForThread(unsigned lg_n) {
+        static thread_local std::vector<std::unique_ptr<RealFFT>> plans;
+        if (plans.size() <= lg_n)
+            plans.resize(lg_n + 1);
+        if (!plans[lg_n])
+            plans[lg_n].reset(new RealFFT(lg_n));
+        return *plans[lg_n];
+    }
+
+private:
+    // In-place unnormalized complex FFT of (re_, im_)
+    void Transform(bool invert) {
+        for (size_t i = 0; i < half_; ++i)
+            if (i < rev_[i]) {
+                std::swap(re_[i], re_[rev_[i]]);
+                std::swap(im_[i], im_[rev_[i]]);
+            }
+
+        double sign = invert ? 1. : -1.;
+        for (size_t len = 2; len <= half_; len <<= 1) {
+            size_t h = len >> 1, step = half_ / len;
+            for (size_t i = 0; i < half_; i += len) {
+                double *ur = &re_[i], *ui = &im_[i], *vr = &re_[i + h], *vi = &im_[i + h];
+                for (size_t j = 0; j < h; ++j) {
+                    double wr = cos_[j * step], wi = sign * sin_[j * step];
+                    double xr = vr[j] * wr - vi[j] * wi, xi = vr[j] * wi + vi[j] * wr;
+                    vr[j] = ur[j] - xr;
+                    vi[j] = ui[j] - xi;
+                    ur[j] += xr;
+                    ui[j] += xi;
+                }
+            }
+        }
+    }
+
+    size_t n_, half_;
+    std::vector<uint32_t> rev_;
+    // exp(2 pi i j / (n / 2)) for the complex transform
+    std::vector<double> cos_, sin_;
+    // exp(2 pi i k / n) for splitting the complex transform into the real one
+    std::vector<double> wcos_, wsin_;
+    std::vector<double> re_, im_;
+    std::vector<complex_t> spectrum_;
+};
+
+}
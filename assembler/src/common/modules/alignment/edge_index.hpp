@@ -53,6 +53,11 @@ private:
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index>
+    void prefetch(const Index *index, const KMer& kmer) const {
+        index->prefetch(kmer);
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
         return index->contains(index->ConstructKWH(kmer));
@@ -141,6 +146,10 @@ public:
         DISPATCH_TO(DeleteKmers, e);
     }
 
+    bool IsBatchable() const override {
+        return true;
+    }
+
     bool contains(const KMer& kmer) const {
         DISPATCH_TO(contains, kmer);
     }
@@ -149,6 +158,10 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    void prefetch(const KMer& kmer) const {
+        DISPATCH_TO(prefetch, kmer);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
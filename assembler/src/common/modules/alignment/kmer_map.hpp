@@ -12,6 +12,9 @@
 #include <tsl/htrie_map.h>
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <vector>
+#include <cstring>
+
 #define XXH_INLINE_ALL
 #include "xxh/xxhash.h"
 
@@ -28,6 +31,7 @@ class KMerMap {
     typedef typename Seq::DataType RawSeqData;
     typedef typename tsl::htrie_map<char, RawSeqData*, str_hash> HTMap;
 
+  public:
     class iterator : public boost::iterator_facade<iterator,
                                                    const std::pair<Kmer, Seq>,
                                                    std::forward_iterator_tag,
@@ -59,7 +63,6 @@ class KMerMap {
         mutable std::string key_out_;
     };
 
-  public:
     KMerMap(unsigned k)
             : k_(k) {
         rawcnt_ = (unsigned)Seq::GetDataSize(k_);
@@ -140,6 +143,151 @@ class KMerMap {
     HTMap mapping_;
 };
 
+// Read-only open addressing snapshot of KMerMap. Keys and values are stored
+// next to each other in a single flat array, lookups are linear probes guarded
+// by 32-bit hash tags, so most of the misses never touch the key itself.
+class FrozenKMerMap {
+    typedef RtSeq Kmer;
+    typedef RtSeq Seq;
+    typedef typename Seq::DataType RawSeqData;
+
+  public:
+    class iterator : public boost::iterator_facade<iterator,
+                                                   const std::pair<Kmer, Seq>,
+                                                   std::forward_iterator_tag,
+                                                   const std::pair<Kmer, Seq>> {
+      public:
+        iterator(const FrozenKMerMap &map, size_t slot)
+                : map_(&map), slot_(slot) {
+            Skip();
+        }
+
+      private:
+        friend class boost::iterator_core_access;
+
+        void Skip() {
+            while (slot_ < map_->tags_.size() && !map_->tags_[slot_])
+                ++slot_;
+        }
+
+        void increment() {
+            ++slot_;
+            Skip();
+        }
+
+        bool equal(const iterator &other) const {
+            return slot_ == other.slot_;
+        }
+
+        const std::pair<Kmer, Seq> dereference() const {
+            const RawSeqData *key = map_->key(slot_);
+            return std::make_pair(Kmer(map_->k_, key), Seq(map_->k_, key + map_->rawcnt_));
+        }
+
+        const FrozenKMerMap *map_;
+        size_t slot_;
+    };
+
+    FrozenKMerMap(unsigned k)
+            : k_(k), rawcnt_((unsigned)Seq::GetDataSize(k)), mask_(0), size_(0) {}
+
+    void build(const KMerMap &map) {
+        size_t capacity = 16;
+        while (capacity * 7 < map.size() * 10)
+            capacity <<= 1;
+
+        tags_.assign(capacity, 0);
+        data_.assign(capacity * 2 * rawcnt_, 0);
+        mask_ = capacity - 1;
+        size_ = map.size();
+
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            const auto &entry = *it;
+            uint64_t h = hash(entry.first.data());
+            uint32_t tag = this->tag(h);
+            size_t slot = h & mask_;
+            while (tags_[slot])
+                slot = (slot + 1) & mask_;
+
+            tags_[slot] = tag;
+            memcpy(key(slot), entry.first.data(), rawcnt_ * sizeof(RawSeqData));
+            memcpy(key(slot) + rawcnt_, entry.second.data(), rawcnt_ * sizeof(RawSeqData));
+        }
+    }
+
+    const RawSeqData *find(const RawSeqData *rawkey) const {
+        if (tags_.empty())
+            return nullptr;
+
+        uint64_t h = hash(rawkey);
+        uint32_t tag = this->tag(h);
+        for (size_t slot = h & mask_; tags_[slot]; slot = (slot + 1) & mask_) {
+            if (tags_[slot] == tag &&
+                0 == memcmp(key(slot), rawkey, rawcnt_ * sizeof(RawSeqData)))
+                return key(slot) + rawcnt_;
+        }
+
+        return nullptr;
+    }
+
+    void prefetch(const RawSeqData *rawkey) const {
+        if (tags_.empty())
+            return;
+
+        size_t slot = hash(rawkey) & mask_;
+        __builtin_prefetch(&tags_[slot]);
+        __builtin_prefetch(key(slot));
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    void clear() {
+        std::vector<uint32_t>().swap(tags_);
+        std::vector<RawSeqData>().swap(data_);
+        mask_ = 0;
+        size_ = 0;
+    }
+
+    iterator begin() const {
+        return iterator(*this, 0);
+    }
+
+    iterator end() const {
+        return iterator(*this, tags_.size());
+    }
+
+  private:
+    uint64_t hash(const RawSeqData *rawkey) const {
+        return XXH3_64bits(rawkey, rawcnt_ * sizeof(RawSeqData));
+    }
+
+    // Zero tag marks an empty slot
+    static uint32_t tag(uint64_t h) {
+        return uint32_t(h >> 32) | 1;
+    }
+
+    RawSeqData *key(size_t slot) {
+        return data_.data() + slot * 2 * rawcnt_;
+    }
+
+    const RawSeqData *key(size_t slot) const {
+        return data_.data() + slot * 2 * rawcnt_;
+    }
+
+    unsigned k_;
+    unsigned rawcnt_;
+    size_t mask_;
+    size_t size_;
+    std::vector<uint32_t> tags_;
+    std::vector<RawSeqData> data_;
+};
+
 }
 
 #endif // __KMER_MAP_HPP__
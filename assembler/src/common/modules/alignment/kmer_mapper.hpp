@@ -27,9 +27,26 @@ class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
     typedef typename Seq::DataType RawSeqData;
 
     unsigned k_;
+    // The mapping is kept in one of the maps only: mapping_ while it is being changed,
+    // frozen_ once it is normalized (mapping_ is released then and restored by Thaw())
     KMerMap mapping_;
+    FrozenKMerMap frozen_;
     bool normalized_;
 
+    void Invalidate() {
+        normalized_ = false;
+        frozen_.clear();
+    }
+
+    void Thaw() {
+        if (!normalized_)
+            return;
+
+        for (auto it = frozen_.begin(); it != frozen_.end(); ++it)
+            mapping_.set(it->first, it->second);
+        Invalidate();
+    }
+
     bool CheckAllDifferent(const Sequence &old_s, const Sequence &new_s) const {
         std::set<Kmer> kmers;
         Kmer kmer = old_s.start<Kmer>(k_) >> 0;
@@ -46,21 +63,53 @@ class KmerMapper : public omnigraph::GraphActionHandler<Graph> {
     }
 
 public:
+    class iterator : public boost::iterator_facade<iterator,
+                                                   const std::pair<Kmer, Seq>,
+                                                   std::forward_iterator_tag,
+                                                   const std::pair<Kmer, Seq>> {
+      public:
+        iterator(KMerMap::iterator iter, FrozenKMerMap::iterator frozen_iter, bool frozen)
+                : iter_(iter), frozen_iter_(frozen_iter), frozen_(frozen) {}
+
+      private:
+        friend class boost::iterator_core_access;
+
+        void increment() {
+            if (frozen_)
+                ++frozen_iter_;
+            else
+                ++iter_;
+        }
+
+        bool equal(const iterator &other) const {
+            return frozen_ ? frozen_iter_ == other.frozen_iter_ : iter_ == other.iter_;
+        }
+
+        const std::pair<Kmer, Seq> dereference() const {
+            return frozen_ ? *frozen_iter_ : *iter_;
+        }
+
+        KMerMap::iterator iter_;
+        FrozenKMerMap::iterator frozen_iter_;
+        bool frozen_;
+    };
+
     KmerMapper(const Graph &g) :
             base(g, "KmerMapper"),
             k_(unsigned(g.k() + 1)),
             mapping_(k_),
+            frozen_(k_),
             normalized_(false) {
     }
 
     virtual ~KmerMapper() {}
 
-    auto begin() const -> decltype(mapping_.begin()) {
-        return mapping_.begin();
+    iterator begin() const {
+        return iterator(mapping_.begin(), frozen_.begin(), normalized_);
     }
 
-    auto end() const -> decltype(mapping_.end()) {
-        return mapping_.end();
+    iterator end() const {
+        return iterator(mapping_.end(), frozen_.end(), normalized_);
     }
 
     void Normalize() {
@@ -87,6 +136,10 @@ public:
             }
         }
 
+        // Every key now points directly to its root, so freeze the mapping:
+        // lookups become a single probe into a flat table
+        frozen_.build(mapping_);
+        mapping_.clear();
         normalized_ = true;
     }
 
@@ -105,6 +158,7 @@ public:
 
     void RemapKmers(const Sequence &old_s, const Sequence &new_s) {
         VERIFY(this->IsAttached());
+        Thaw();
         size_t old_length = old_s.size() - k_ + 1;
         size_t new_length = new_s.size() - k_ + 1;
         UniformPositionAligner aligner(old_s.size() - k_ + 1,
@@ -140,7 +194,6 @@ public:
             }
 
             mapping_.set(old_kmer, new_kmer);
-            normalized_ = false;
         }
     }
 
@@ -149,7 +202,14 @@ public:
         RemapKmers(this->g().EdgeNucls(edge1), this->g().EdgeNucls(edge2));
     }
 
+    bool IsBatchable() const override {
+        return true;
+    }
+
     const RawSeqData* GetRoot(const Kmer &kmer) const {
+        if (normalized_)
+            return frozen_.find(kmer.data());
+
         const RawSeqData *answer = nullptr;
         const RawSeqData *rawval = mapping_.find(kmer);
 
@@ -165,6 +225,11 @@ public:
 
     Kmer Substitute(const Kmer &kmer) const {
         VERIFY(this->IsAttached());
+        if (normalized_) {
+            const auto *rawval = frozen_.find(kmer.data());
+            return rawval ? Kmer(k_, rawval) : kmer;
+        }
+
         const auto *rawval = mapping_.find(kmer);
         if (rawval == nullptr)
             return kmer;
@@ -180,9 +245,38 @@ public:
     }
 
     bool CanSubstitute(const Kmer &kmer) const {
+        if (normalized_)
+            return frozen_.find(kmer.data()) != nullptr;
+
         return mapping_.count(kmer);
     }
 
+    // Combined CanSubstitute + Substitute, needs a single lookup
+    // for normalized mapper
+    bool TrySubstitute(const Kmer &kmer, Kmer &result) const {
+        VERIFY(this->IsAttached());
+        if (!normalized_) {
+            if (!mapping_.count(kmer))
+                return false;
+            result = Substitute(kmer);
+            return true;
+        }
+
+        const auto *rawval = frozen_.find(kmer.data());
+        if (rawval == nullptr)
+            return false;
+
+        result = Kmer(k_, rawval);
+        return true;
+    }
+
+    // Hint that the k-mer is going to be looked up soon. Only meaningful
+    // for the normalized mapper, no-op otherwise
+    void prefetch(const Kmer &kmer) const {
+        if (normalized_)
+            frozen_.prefetch(kmer.data());
+    }
+
     void BinWrite(std::ostream &file) const {
         size_t sz = size();
         file.write((const char *) &sz, sizeof(sz));
@@ -205,16 +299,16 @@ public:
             Seq::BinRead(file, &value);
             mapping_.set(key, value);
         }
-        normalized_ = false;
+        Invalidate();
     }
 
     void clear() {
-        normalized_ = false;
+        Invalidate();
         return mapping_.clear();
     }
 
     size_t size() const {
-        return mapping_.size();
+        return normalized_ ? frozen_.size() : mapping_.size();
     }
 };
 
@@ -12,6 +12,7 @@ using namespace std;
 
 const int DijkstraGraphSequenceBase::SHORT_SEQ_LENGTH;
 const int DijkstraGraphSequenceBase::ED_DEVIATION;
+const size_t DijkstraGraphSequenceBase::NO_STATE;
 
 bool DijkstraGraphSequenceBase::IsBetter(int seq_ind, int ed) {
     if (seq_ind == (int) ss_.size() ) {
@@ -30,23 +31,58 @@ bool DijkstraGraphSequenceBase::IsBetter(int seq_ind, int ed) {
     return false;
 }
 
+void DijkstraGraphSequenceBase::Enqueue(size_t id) {
+    StateInfo &info = states_[id];
+    VERIFY(!info.queued);
+    info.queued = true;
+    info.version += 1;
+    queue_size_ += 1;
+    heap_.push_back({info.score, id, info.version});
+    std::push_heap(heap_.begin(), heap_.end(), HeapGreater{states_});
+}
+
+void DijkstraGraphSequenceBase::Dequeue(size_t id) {
+    StateInfo &info = states_[id];
+    if (!info.queued)
+        return;
+    info.queued = false;
+    info.version += 1;
+    queue_size_ -= 1;
+}
+
+size_t DijkstraGraphSequenceBase::PopQueue() {
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), HeapGreater{states_});
+        HeapEntry entry = heap_.back();
+        heap_.pop_back();
+        if (states_[entry.id].queued && states_[entry.id].version == entry.version) {
+            Dequeue(entry.id);
+            return entry.id;
+        }
+    }
+    return NO_STATE;
+}
+
 void DijkstraGraphSequenceBase::Update(const QueueState &state, const QueueState &prev_state, int score) {
-    if (visited_.count(state) > 0) {
-        if (visited_[state] >= score) {
+    size_t prev = prev_state.empty() ? NO_STATE : StateId(prev_state);
+    auto it = index_.find(state);
+    if (it != index_.end()) {
+        size_t id = it->second;
+        if (states_[id].score >= score) {
             ++ updates_;
-            q_.erase(make_pair(visited_[state], state));
+            Dequeue(id);
             if (IsBetter(state.i, score)) {
-                q_.insert(make_pair(score, state));
-                visited_[state] = score;
-                prev_states_[state] = prev_state;
+                states_[id].score = score;
+                states_[id].prev = prev;
+                Enqueue(id);
             }
         }
     } else {
         if (IsBetter(state.i, score)) {
             ++ updates_;
-            visited_.insert(make_pair(state, score));
-            prev_states_.insert(make_pair(state, prev_state));
-            q_.insert(make_pair(score, state));
+            index_.emplace(state, states_.size());
+            states_.emplace_back(state, score, prev);
+            Enqueue(states_.size() - 1);
         }
     }
 }
@@ -92,7 +128,7 @@ void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueStat
 }
 
 bool DijkstraGraphSequenceBase::QueueLimitsExceeded(size_t iter) {
-    return_code_.queue_limit = q_.size() > queue_limit_;
+    return_code_.queue_limit = queue_size_ > queue_limit_;
     return_code_.iter_limit = iter > iter_limit_;
     return return_code_.status;
 }
@@ -102,15 +138,15 @@ bool DijkstraGraphSequenceBase::RunDijkstra() {
     size_t iter = 0;
     QueueState cur_state;
     int ed = 0;
-    while (q_.size() > 0 &&
+    while (queue_size_ > 0 &&
             !QueueLimitsExceeded(iter) &&
             ed <= path_max_length_ &&
             updates_ < gap_cfg_.updates_limit) {
-        cur_state = q_.begin()->second;
-        ed = visited_[cur_state];
+        size_t id = PopQueue();
+        cur_state = states_[id].state;
+        ed = states_[id].score;
         ++ iter;
-        q_.erase(q_.begin());
-        if (visited_.count(end_qstate_) > 0) {
+        if (index_.count(end_qstate_) > 0) {
             found_path = true;
         }
         if (IsEndPosition(cur_state)) {
@@ -134,15 +170,16 @@ void DijkstraGraphSequenceBase::CloseGap() {
         return_code_.no_path = true;
     }
     if (found_path) {
-        QueueState state(end_qstate_);
-        while (!state.empty()) {
-            min_score_ = visited_[end_qstate_];
-            int start_edge = prev_states_[state].i;
-            int end_edge =  state.i;
-            mapping_path_.push_back(state.gs.e,
+        size_t id = StateId(end_qstate_);
+        min_score_ = id == NO_STATE ? 0 : states_[id].score;
+        while (id != NO_STATE) {
+            const StateInfo &info = states_[id];
+            int start_edge = info.prev == NO_STATE ? 0 : states_[info.prev].state.i;
+            int end_edge =  info.state.i;
+            mapping_path_.push_back(info.state.gs.e,
                                     omnigraph::MappingRange(Range(start_edge, end_edge),
-                                            Range(state.gs.start_pos, state.gs.end_pos) ));
-            state = prev_states_[state];
+                                            Range(info.state.gs.start_pos, info.state.gs.end_pos) ));
+            id = info.prev;
         }
         mapping_path_.reverse();
     }
@@ -12,6 +12,8 @@
 #include "sequence/sequence_tools.hpp"
 #include "utils/perf/perfcounter.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace sensitive_aligner {
 
 using debruijn_graph::EdgeId;
@@ -233,10 +235,57 @@ class DijkstraGraphSequenceBase {
   private:
     static const int SHORT_SEQ_LENGTH = 100;
     static const int ED_DEVIATION = 20;
+    static const size_t NO_STATE = -1ull;
+
+    // All the visited states are kept in a single arena, the index maps
+    // the state to its position there
+    struct StateInfo {
+        QueueState state;
+        int score;
+        size_t prev;
+        // Incremented every time the state leaves or re-enters the queue,
+        // heap entries with outdated version are skipped
+        unsigned version;
+        bool queued;
+
+        StateInfo(const QueueState &state_, int score_, size_t prev_)
+            : state(state_), score(score_), prev(prev_), version(0), queued(false)
+        {}
+    };
+
+    struct HeapEntry {
+        int score;
+        size_t id;
+        unsigned version;
+    };
+
+    // Orders by score, then by the state itself (same as std::set of pairs did)
+    struct HeapGreater {
+        const std::vector<StateInfo> &states;
+
+        bool operator()(const HeapEntry &a, const HeapEntry &b) const {
+            if (a.score != b.score)
+                return a.score > b.score;
+            return states[b.id].state < states[a.id].state;
+        }
+    };
+
+    size_t StateId(const QueueState &state) const {
+        auto it = index_.find(state);
+        return it == index_.end() ? NO_STATE : it->second;
+    }
+
+    void Enqueue(size_t id);
+
+    void Dequeue(size_t id);
+
+    // Returns NO_STATE if the queue is empty
+    size_t PopQueue();
 
-    std::set<std::pair<int, QueueState>> q_;
-    std::unordered_map<QueueState, int> visited_;
-    std::unordered_map<QueueState, QueueState> prev_states_;
+    std::vector<StateInfo> states_;
+    phmap::flat_hash_map<QueueState, size_t> index_;
+    std::vector<HeapEntry> heap_;
+    size_t queue_size_ = 0;
     std::vector<int> best_ed_;
 
     const size_t queue_limit_;
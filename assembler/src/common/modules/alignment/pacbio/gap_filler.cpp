@@ -65,19 +65,22 @@ GapFillerResult GapFiller::BestScoredPathDijkstra(const string &s,
         }
         return dijkstra_res;
     }
+    if (s_len > 0) {
+        MyersGapFiller myers_filler(g_, gap_cfg, s,
+                                    start_pos.edgeid, end_pos.edgeid,
+                                    (int) start_pos.position, (int) end_pos.position,
+                                    ed_limit, vertex_pathlen);
+        myers_filler.CloseGap();
+        if (!myers_filler.limits_exceeded())
+            return ClosingResult(myers_filler);
+        DEBUG("Myers graph search exceeded limits, falling back to Dijkstra");
+    }
     DijkstraGapFiller gap_filler(g_, gap_cfg, s,
                                  start_pos.edgeid, end_pos.edgeid,
                                  (int) start_pos.position, (int) end_pos.position,
                                  ed_limit, vertex_pathlen);
     gap_filler.CloseGap();
-    dijkstra_res.score = gap_filler.edit_distance();
-    dijkstra_res.return_code = gap_filler.return_code();
-    if (dijkstra_res.score == numeric_limits<int>::max()) {
-        DEBUG("Dijkstra didn't find anything")
-        return dijkstra_res;
-    }
-    dijkstra_res.full_intermediate_path = gap_filler.path();
-    return dijkstra_res;
+    return ClosingResult(gap_filler);
 }
 
 GapFillerResult GapFiller::BestScoredPathBruteForce(const string &seq_string,
@@ -269,19 +272,16 @@ GapFillerResult GapFiller::Run(Sequence &s,
         return res;
     }
     utils::perf_counter pc;
-    DijkstraEndsReconstructor algo(g_, ends_cfg, s.str(), start_pos.edgeid, (int) start_pos.position, score);
+    std::string ss = s.str();
+    MyersEndsReconstructor myers_algo(g_, ends_cfg, ss, start_pos.edgeid, (int) start_pos.position, score);
+    myers_algo.CloseGap();
+    if (!myers_algo.limits_exceeded())
+        return RestoreEnd(myers_algo, start_pos, forward, path, range, old_start_pos);
+
+    DEBUG("Myers graph search exceeded limits, falling back to Dijkstra");
+    DijkstraEndsReconstructor algo(g_, ends_cfg, ss, start_pos.edgeid, (int) start_pos.position, score);
     algo.CloseGap();
-    score = algo.edit_distance();
-    res.return_code = algo.return_code();
-    if (score == numeric_limits<int>::max()) {
-        DEBUG("EdgeDijkstra didn't find anything edge=" << start_pos.edgeid.int_id()
-              << " s_start=" << start_pos.position << " seq_len=" << s.size())
-        return res;
-    }
-    vector<EdgeId> ans = algo.path();
-    MappingPoint p(forward ? algo.seq_end_position() + range.path_end.seq_pos : range.path_start.seq_pos - algo.seq_end_position(), algo.path_end_position());
-    UpdatePath(path, ans, p, range, forward, old_start_pos);
-    return res;
+    return RestoreEnd(algo, start_pos, forward, path, range, old_start_pos);
 }
 
 } // namespace sensitive_aligner
\ No newline at end of file
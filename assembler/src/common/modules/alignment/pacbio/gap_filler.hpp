@@ -13,6 +13,7 @@
 
 #include "modules/alignment/bwa_index.hpp"
 #include "modules/alignment/pacbio/gap_dijkstra.hpp"
+#include "modules/alignment/pacbio/myers_graph_aligner.hpp"
 
 namespace sensitive_aligner {
 using debruijn_graph::EdgeId;
@@ -119,6 +120,39 @@ class GapFiller {
                     std::vector<EdgeId> &ans,
                     MappingPoint p, PathRange &range, bool forward, GraphPosition &old_start_pos) const;
 
+    // Works with both Dijkstra and Myers gap fillers
+    template<class GapClosingAlgo>
+    GapFillerResult ClosingResult(const GapClosingAlgo &gap_filler) const {
+        GapFillerResult res;
+        res.score = gap_filler.edit_distance();
+        res.return_code = gap_filler.return_code();
+        if (res.score == std::numeric_limits<int>::max()) {
+            DEBUG("Dijkstra didn't find anything")
+            return res;
+        }
+        res.full_intermediate_path = gap_filler.path();
+        return res;
+    }
+
+    // Works with both Dijkstra and Myers ends reconstructors
+    template<class EndsClosingAlgo>
+    GapFillerResult RestoreEnd(const EndsClosingAlgo &algo,
+                               const GraphPosition &start_pos, bool forward,
+                               std::vector<debruijn_graph::EdgeId> &path,
+                               PathRange &range, GraphPosition &old_start_pos) const {
+        GapFillerResult res;
+        res.return_code = algo.return_code();
+        if (algo.edit_distance() == std::numeric_limits<int>::max()) {
+            DEBUG("EdgeDijkstra didn't find anything edge=" << start_pos.edgeid.int_id()
+                  << " s_start=" << start_pos.position << " seq_len=" << algo.seq_end_position())
+            return res;
+        }
+        std::vector<EdgeId> ans = algo.path();
+        MappingPoint p(forward ? algo.seq_end_position() + range.path_end.seq_pos : range.path_start.seq_pos - algo.seq_end_position(), algo.path_end_position());
+        UpdatePath(path, ans, p, range, forward, old_start_pos);
+        return res;
+    }
+
     const debruijn_graph::Graph &g_;
     const GAlignerConfig &cfg_;
 };
@@ -0,0 +1,276 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "modules/alignment/pacbio/myers_graph_aligner.hpp"
+
+#include "sequence/nucl.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace sensitive_aligner {
+
+using namespace std;
+
+const int MyersGraphSequenceBase::WORD_SIZE;
+const size_t MyersGraphSequenceBase::NO_NODE;
+const int MyersGraphSequenceBase::INF_SCORE;
+const size_t MyersGraphSequenceBase::MEMORY_LIMIT;
+
+// One step of Myers' algorithm for a 64-row block (see Hyyro's multi-block formulation),
+// hin and the returned hout are the horizontal deltas at the top and at the bottom of the block
+static inline int AdvanceBlock(uint64_t &pv, uint64_t &mv, uint64_t eq, int hin) {
+    uint64_t hin_neg = hin < 0 ? 1 : 0;
+    uint64_t xv = eq | mv;
+    eq |= hin_neg;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    int hout = int(ph >> 63) - int(mh >> 63);
+    ph <<= 1;
+    mh <<= 1;
+    mh |= hin_neg;
+    ph |= hin > 0 ? 1 : 0;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+MyersGraphSequenceBase::MyersGraphSequenceBase(const debruijn_graph::Graph &g,
+                                               const DijkstraParams &gap_cfg,
+                                               const std::string &ss,
+                                               EdgeId start_e, int start_p, int path_max_length)
+        : g_(g), gap_cfg_(gap_cfg), ss_(ss),
+          start_e_(start_e), start_p_(start_p),
+          blocks_(std::max<size_t>((ss_.size() + WORD_SIZE - 1) / WORD_SIZE, 1)),
+          peq_(4 * blocks_, 0),
+          pv_(blocks_), mv_(blocks_), score_(blocks_),
+          last_block_(0), col_(0),
+          rows_(ss_.size() + 1),
+          k_(path_max_length), min_score_(INF_SCORE),
+          best_node_(NO_NODE), end_pos_(0) {
+    // Sequence positions match a nucleotide, the padding rows of the last block match nothing
+    for (size_t i = 0; i < ss_.size(); ++i) {
+        if (!is_nucl(ss_[i]))
+            continue;
+        peq_[dignucl(ss_[i]) * blocks_ + i / WORD_SIZE] |= 1ull << (i % WORD_SIZE);
+    }
+
+    // The first column: D[i][0] = i
+    for (size_t b = 0; b < blocks_; ++b) {
+        pv_[b] = -1ull;
+        mv_[b] = 0;
+        score_[b] = int((b + 1) * WORD_SIZE);
+    }
+    last_block_ = std::min(int(blocks_) - 1, std::max(k_, 0) / WORD_SIZE);
+
+    nodes_.push_back({start_e_, NO_NODE, last_block_, col_});
+    node_words_.insert(node_words_.end(), pv_.begin(), pv_.end());
+    node_words_.insert(node_words_.end(), mv_.begin(), mv_.end());
+    node_scores_.insert(node_scores_.end(), score_.begin(), score_.end());
+    heap_.push_back({0, 0});
+}
+
+bool MyersGraphSequenceBase::Advance(unsigned char c) {
+    const uint64_t *peq = &peq_[c * blocks_];
+    // D[0][j] = j, so the top delta is always +1
+    int hout = 1;
+    for (int b = 0; b <= last_block_; ++b) {
+        hout = AdvanceBlock(pv_[b], mv_[b], peq[b], hout);
+        score_[b] += hout;
+    }
+    col_ += 1;
+
+    // Ukkonen's cut-off, as in edlib: rows below the last active block are all above the limit
+    if (last_block_ + 1 < int(blocks_) && score_[last_block_] - hout <= k_ &&
+        ((peq[last_block_ + 1] & 1) || hout < 0)) {
+        int b = ++last_block_;
+        pv_[b] = -1ull;
+        mv_[b] = 0;
+        score_[b] = score_[b - 1] - hout + WORD_SIZE;
+        score_[b] += AdvanceBlock(pv_[b], mv_[b], peq[b], hout);
+    }
+    while (last_block_ >= 0 && score_[last_block_] >= k_ + WORD_SIZE)
+        last_block_ -= 1;
+
+    return last_block_ >= 0;
+}
+
+int MyersGraphSequenceBase::LastRowScore() const {
+    if (ss_.empty())
+        return col_;
+    if (last_block_ + 1 != int(blocks_))
+        return INF_SCORE;
+
+    // Subtract the vertical deltas of the padding rows below the last sequence position
+    unsigned last_bit = unsigned((ss_.size() - 1) % WORD_SIZE);
+    uint64_t padding = last_bit + 1 == WORD_SIZE ? 0 : -1ull << (last_bit + 1);
+    return score_[last_block_] - __builtin_popcountll(pv_[last_block_] & padding)
+                               + __builtin_popcountll(mv_[last_block_] & padding);
+}
+
+void MyersGraphSequenceBase::UpdateBest(int score, EdgeId e, size_t pos, size_t node) {
+    if (score > k_ || score >= min_score_)
+        return;
+    min_score_ = score;
+    best_node_ = node;
+    best_e_ = e;
+    end_pos_ = pos;
+    // Only strictly better paths are of interest from now on
+    k_ = score - 1;
+}
+
+void MyersGraphSequenceBase::LoadColumn(size_t node) {
+    const Node &n = nodes_[node];
+    const uint64_t *words = &node_words_[2 * blocks_ * node];
+    std::copy(words, words + blocks_, pv_.begin());
+    std::copy(words + blocks_, words + 2 * blocks_, mv_.begin());
+    std::copy(&node_scores_[blocks_ * node], &node_scores_[blocks_ * node] + blocks_, score_.begin());
+    last_block_ = n.last_block;
+    col_ = n.col;
+}
+
+size_t MyersGraphSequenceBase::MemoryUsed() const {
+    return node_words_.size() * sizeof(uint64_t) + node_scores_.size() * sizeof(int) +
+           row_min_.size() * sizeof(int) + nodes_.size() * sizeof(Node) +
+           heap_.size() * sizeof(HeapEntry);
+}
+
+void MyersGraphSequenceBase::AddNode(size_t parent, EdgeId e) {
+    // Restore the column values, the rows above the limit are never useful
+    size_t m = ss_.size();
+    int bound = INF_SCORE;
+    std::fill(rows_.begin(), rows_.end(), INF_SCORE);
+    if (col_ <= k_)
+        rows_[0] = bound = col_;
+    for (int b = 0; b <= last_block_; ++b) {
+        int v = b == 0 ? col_ : score_[b - 1];
+        for (size_t r = 0, row = size_t(b) * WORD_SIZE + 1; r < WORD_SIZE && row <= m; ++r, ++row) {
+            v += int((pv_[b] >> r) & 1) - int((mv_[b] >> r) & 1);
+            if (v <= k_) {
+                rows_[row] = v;
+                bound = std::min(bound, v);
+            }
+        }
+    }
+    if (bound == INF_SCORE)
+        return;
+
+    // Drop the column if some earlier columns at this vertex are at least as good in every row
+    auto entry = row_min_index_.emplace(g_.EdgeEnd(e), row_min_.size());
+    if (entry.second)
+        row_min_.resize(row_min_.size() + m + 1, INF_SCORE);
+    int *row_min = &row_min_[entry.first->second];
+    bool improves = false;
+    for (size_t i = 0; i <= m; ++i) {
+        if (rows_[i] < row_min[i]) {
+            row_min[i] = rows_[i];
+            improves = true;
+        }
+    }
+    if (!improves)
+        return;
+
+    size_t id = nodes_.size();
+    nodes_.push_back({e, parent, last_block_, col_});
+    node_words_.insert(node_words_.end(), pv_.begin(), pv_.end());
+    node_words_.insert(node_words_.end(), mv_.begin(), mv_.end());
+    node_scores_.insert(node_scores_.end(), score_.begin(), score_.end());
+    heap_.push_back({bound, id});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+
+    if (heap_.size() > gap_cfg_.queue_limit || MemoryUsed() > MEMORY_LIMIT)
+        return_code_.queue_limit = true;
+}
+
+void MyersGraphSequenceBase::Scan(size_t node, EdgeId e, size_t from) {
+    size_t len = ScanLength(e, from);
+    size_t edge_len = g_.length(e);
+    LoadColumn(node);
+    if (node != 0)
+        CheckEnd(e, from, node);
+    if (from == edge_len && CanEnter(e))
+        AddNode(node, e);
+
+    const Sequence &nucls = g_.EdgeNucls(e);
+    for (size_t pos = from; pos < from + len && !limits_exceeded(); ++pos) {
+        if (!Advance((unsigned char) nucls[pos]))
+            return;
+        CheckEnd(e, pos + 1, node);
+        if (pos + 1 == edge_len && CanEnter(e))
+            AddNode(node, e);
+    }
+}
+
+void MyersGraphSequenceBase::CloseGap() {
+    size_t iter = 0;
+    while (!heap_.empty() && !limits_exceeded()) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+        HeapEntry entry = heap_.back();
+        heap_.pop_back();
+        // The column minimum never decreases along the path
+        if (entry.bound > k_)
+            break;
+        if (++iter > gap_cfg_.iteration_limit) {
+            return_code_.iter_limit = true;
+            break;
+        }
+
+        if (entry.id == 0) {
+            Scan(0, start_e_, start_p_);
+        } else {
+            for (EdgeId e : g_.OutgoingEdges(g_.EdgeEnd(nodes_[entry.id].e)))
+                Scan(entry.id, e, 0);
+        }
+    }
+    DEBUG("Myers graph search: iterations=" << iter << " columns=" << nodes_.size()
+          << " memory=" << MemoryUsed());
+
+    if (min_score_ == INF_SCORE)
+        return_code_.no_path = true;
+}
+
+std::vector<EdgeId> MyersGraphSequenceBase::path() const {
+    std::vector<EdgeId> res;
+    if (best_node_ == NO_NODE)
+        return res;
+    res.push_back(best_e_);
+    for (size_t n = best_node_; n != 0; n = nodes_[n].parent)
+        res.push_back(nodes_[n].e);
+    std::reverse(res.begin(), res.end());
+    return res;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+size_t MyersGapFiller::ScanLength(EdgeId e, size_t from) const {
+    if (CanEnter(e))
+        return g_.length(e) - from;
+    if (e == end_e_ && end_p_ > from)
+        return end_p_ - from;
+    return 0;
+}
+
+bool MyersGapFiller::CanEnter(EdgeId e) const {
+    return Reachable(g_.EdgeEnd(e));
+}
+
+void MyersGapFiller::CheckEnd(EdgeId e, size_t pos, size_t node) {
+    if (e == end_e_ && pos == end_p_)
+        UpdateBest(LastRowScore(), e, pos, node);
+}
+
+size_t MyersEndsReconstructor::ScanLength(EdgeId e, size_t from) const {
+    // The alignment might end inside the last k-mer of the edge
+    return g_.length(e) + g_.k() - from;
+}
+
+void MyersEndsReconstructor::CheckEnd(EdgeId e, size_t pos, size_t node) {
+    if (pos > 0)
+        UpdateBest(LastRowScore(), e, pos, node);
+}
+
+} // namespace sensitive_aligner
@@ -0,0 +1,200 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "modules/alignment/pacbio/gap_dijkstra.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sensitive_aligner {
+
+/**
+ * @brief  Aligns the sequence to the graph paths starting at the given position by propagating
+ *         Myers bit-vector edit distance columns along the edges (one 64-bit block per 64 sequence
+ *         nucleotides, Ukkonen's cut-off on the last active block).
+ *
+ *         The sequence is aligned globally, the columns are branched at the vertices. The search is
+ *         best-first on the column minimum (which never decreases along a path), a vertex column is
+ *         dropped if it does not improve any row of the best columns seen at this vertex before.
+ *         So the edit distance found is optimal within path_max_length.
+ *
+ *         The search stops when it exceeds the queue / iteration limits or its memory budget,
+ *         then limits_exceeded() is true and the caller is expected to fall back to Dijkstra.
+ *         Only the edge path is restored, per-edge sequence ranges are not available.
+ */
+class MyersGraphSequenceBase {
+  public:
+    MyersGraphSequenceBase(const debruijn_graph::Graph &g,
+                           const DijkstraParams &gap_cfg,
+                           const std::string &ss,
+                           EdgeId start_e, int start_p, int path_max_length);
+
+    virtual ~MyersGraphSequenceBase() {}
+
+    void CloseGap();
+
+    std::vector<EdgeId> path() const;
+
+    int edit_distance() const {
+        return min_score_;
+    }
+
+    DijkstraReturnCode return_code() const {
+        return return_code_;
+    }
+
+    bool limits_exceeded() const {
+        return return_code_.queue_limit || return_code_.iter_limit;
+    }
+
+    int path_end_position() const {
+        return (int) end_pos_;
+    }
+
+    int seq_end_position() const {
+        return (int) ss_.size();
+    }
+
+  protected:
+    // The number of nucleotides of the edge to be scanned starting from the position
+    virtual size_t ScanLength(EdgeId e, size_t from) const = 0;
+
+    // Whether the search may continue through the edge end
+    virtual bool CanEnter(EdgeId e) const = 0;
+
+    // Called for every column, pos is the number of edge nucleotides consumed
+    virtual void CheckEnd(EdgeId e, size_t pos, size_t node) = 0;
+
+    // Edit distance of the whole sequence against the path up to the current column
+    int LastRowScore() const;
+
+    // Records the path ending at the current column if it is the best one
+    void UpdateBest(int score, EdgeId e, size_t pos, size_t node);
+
+    const debruijn_graph::Graph &g_;
+    const DijkstraParams gap_cfg_;
+    const std::string ss_;
+    const EdgeId start_e_;
+    const size_t start_p_;
+
+  private:
+    static const int WORD_SIZE = 64;
+    static const size_t NO_NODE = -1ull;
+    static const int INF_SCORE = std::numeric_limits<int>::max();
+    // Memory for the stored columns and per-vertex row minima, Dijkstra is used above it
+    static const size_t MEMORY_LIMIT = 1ull << 25;
+
+    // A column stored at a vertex, or at the start position for the root
+    struct Node {
+        EdgeId e;
+        size_t parent;
+        int last_block;
+        int col;
+    };
+
+    struct HeapEntry {
+        int bound;
+        size_t id;
+
+        bool operator>(const HeapEntry &other) const {
+            return bound > other.bound || (bound == other.bound && id > other.id);
+        }
+    };
+
+    // Advances the current column by one text nucleotide.
+    // Returns false if no row is within the edit distance limit anymore.
+    bool Advance(unsigned char c);
+
+    void LoadColumn(size_t node);
+
+    void AddNode(size_t parent, EdgeId e);
+
+    void Scan(size_t node, EdgeId e, size_t from);
+
+    size_t MemoryUsed() const;
+
+    size_t blocks_;
+    std::vector<uint64_t> peq_;
+
+    // Current column
+    std::vector<uint64_t> pv_;
+    std::vector<uint64_t> mv_;
+    std::vector<int> score_;
+    int last_block_;
+    int col_;
+
+    std::vector<Node> nodes_;
+    std::vector<uint64_t> node_words_;
+    std::vector<int> node_scores_;
+    std::vector<HeapEntry> heap_;
+
+    // Element-wise minimum of the columns that reached the vertex
+    phmap::flat_hash_map<debruijn_graph::VertexId, size_t> row_min_index_;
+    std::vector<int> row_min_;
+    std::vector<int> rows_;
+
+    int k_;
+    int min_score_;
+    size_t best_node_;
+    EdgeId best_e_;
+    size_t end_pos_;
+    DijkstraReturnCode return_code_;
+};
+
+
+class MyersGapFiller: public MyersGraphSequenceBase {
+  public:
+    MyersGapFiller(const debruijn_graph::Graph &g,
+                   const GapClosingConfig &gap_cfg,
+                   const std::string &ss,
+                   EdgeId start_e, EdgeId end_e,
+                   int start_p, int end_p, int path_max_length,
+                   const std::unordered_map<debruijn_graph::VertexId, size_t> &reachable_vertex)
+        : MyersGraphSequenceBase(g, gap_cfg, ss, start_e, start_p, path_max_length)
+        , end_e_(end_e), end_p_(end_p)
+        , reachable_vertex_(reachable_vertex) {}
+
+  private:
+    size_t ScanLength(EdgeId e, size_t from) const override;
+
+    bool CanEnter(EdgeId e) const override;
+
+    void CheckEnd(EdgeId e, size_t pos, size_t node) override;
+
+    bool Reachable(debruijn_graph::VertexId v) const {
+        return reachable_vertex_.size() == 0 || reachable_vertex_.count(v) > 0;
+    }
+
+    const EdgeId end_e_;
+    const size_t end_p_;
+    const std::unordered_map<debruijn_graph::VertexId, size_t> &reachable_vertex_;
+};
+
+
+class MyersEndsReconstructor: public MyersGraphSequenceBase {
+  public:
+    MyersEndsReconstructor(const debruijn_graph::Graph &g,
+                           const EndsClosingConfig &gap_cfg,
+                           const std::string &ss,
+                           EdgeId start_e, int start_p, int path_max_length)
+        : MyersGraphSequenceBase(g, gap_cfg, ss, start_e, start_p, path_max_length) {}
+
+  private:
+    size_t ScanLength(EdgeId e, size_t from) const override;
+
+    bool CanEnter(EdgeId) const override {
+        return true;
+    }
+
+    void CheckEnd(EdgeId e, size_t pos, size_t node) override;
+};
+
+} // namespace sensitive_aligner
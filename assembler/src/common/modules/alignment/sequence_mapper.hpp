@@ -299,6 +299,11 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   size_t k_;
   bool optimization_on_;
 
+  // While k-mers are looked up one after another (i.e. threading fails), the mapper
+  // and index data for the k-mer this many positions ahead are prefetched to hide
+  // the latency
+  static constexpr size_t kPrefetchDistance = 8;
+
   bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
                 RangeMappings& range_mappings) const {
     const auto& position = index_.get(kmer);
@@ -362,8 +367,9 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
         return true;
     }
 
-    if (kmer_mapper_.CanSubstitute(kmer)) {
-        FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+    Kmer subst = kmer;
+    if (kmer_mapper_.TrySubstitute(kmer, subst)) {
+        FindKmer(subst, kmer_pos, passed_edges, range_mapping);
         return false;
     }
 
@@ -389,11 +395,26 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     }
 
     Kmer kmer = sequence.start<Kmer>(k_);
+    Kmer ahead = kmer;
+    size_t ahead_end = k_;
+    for (; ahead_end < std::min(k_ + kPrefetchDistance, sequence.size()); ++ahead_end) {
+      ahead <<= sequence[ahead_end];
+      kmer_mapper_.prefetch(ahead);
+      index_.prefetch(ahead);
+    }
+
     bool try_thread = false;
     try_thread = ProcessKmer(kmer, 0, passed_edges,
                              range_mapping, try_thread);
     for (size_t i = k_; i < sequence.size(); ++i) {
       kmer <<= sequence[i];
+      if (ahead_end < sequence.size()) {
+        ahead <<= sequence[ahead_end++];
+        if (!try_thread) {
+          kmer_mapper_.prefetch(ahead);
+          index_.prefetch(ahead);
+        }
+      }
       try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
                                range_mapping, try_thread);
       if (only_simple && passed_edges.size() > 1)
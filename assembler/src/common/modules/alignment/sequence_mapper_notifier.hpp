@@ -17,6 +17,7 @@
 
 #include "utils/perf/timetracer.hpp"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -51,23 +52,59 @@ public:
 
     void Subscribe(size_t lib_index, SequenceMapperListener* listener);
 
+    template<class ReadType>
+    struct LibraryStreams {
+        size_t lib_index;
+        io::ReadStreamList<ReadType> *streams;
+        const SequenceMapperT *mapper;
+    };
+
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
-        std::string lib_str = std::to_string(lib_index);
+        ProcessLibraries(std::vector<LibraryStreams<ReadType>>{{lib_index, &streams, &mapper}}, threads_count);
+    }
+
+    /**
+     * @brief  Maps the reads of several libraries in a single pass. Streams of all the libraries
+     *         are scheduled dynamically over one thread team, so a thread that has finished its
+     *         stream proceeds with the next library instead of waiting for the others. Every
+     *         stream is read by one thread at a time, hence its index in the library is passed
+     *         to the listeners of the library as the thread index.
+     */
+    template<class ReadType>
+    void ProcessLibraries(const std::vector<LibraryStreams<ReadType>> &libs, size_t threads_count = 0) {
+        std::string lib_str;
+        for (const auto &lib : libs)
+            lib_str += (lib_str.empty() ? "" : ",") + std::to_string(lib.lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
+
+        std::vector<size_t> lib_threads(libs.size());
+        std::vector<std::pair<size_t, size_t>> chunks;
+        size_t max_streams = 0;
+        for (size_t l = 0; l < libs.size(); ++l) {
+            auto &streams = *libs[l].streams;
+            max_streams = std::max(max_streams, streams.size());
+            lib_threads[l] = std::max(threads_count, streams.size());
+            for (size_t i = 0; i < streams.size(); ++i)
+                chunks.emplace_back(l, i);
+        }
         if (threads_count == 0)
-            threads_count = streams.size();
+            threads_count = max_streams;
 
-        streams.reset();
-        NotifyStartProcessLibrary(lib_index, threads_count);
+        for (size_t l = 0; l < libs.size(); ++l) {
+            libs[l].streams->reset();
+            NotifyStartProcessLibrary(libs[l].lib_index, lib_threads[l]);
+        }
         size_t counter = 0, n = 15;
 
-        #pragma omp parallel for num_threads(threads_count) shared(counter)
-        for (size_t i = 0; i < streams.size(); ++i) {
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(threads_count) shared(counter)
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            const auto &lib = libs[chunks[c].first];
+            size_t i = chunks[c].second;
             size_t size = 0;
             ReadType r;
-            auto& stream = streams[i];
+            auto& stream = (*lib.streams)[i];
             while (!stream.eof()) {
                 if (size == BUFFER_SIZE) {
                     #pragma omp critical
@@ -78,22 +115,24 @@ public:
                             n += 1;
                         }
                         size = 0;
-                        NotifyMergeBuffer(lib_index, i);
+                        NotifyMergeBuffer(lib.lib_index, i);
                     }
                 }
                 stream >> r;
                 ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
+                NotifyProcessRead(r, *lib.mapper, lib.lib_index, i);
             }
             #pragma omp atomic
             counter += size;
         }
 
-        for (size_t i = 0; i < threads_count; ++i)
-            NotifyMergeBuffer(lib_index, i);
+        for (size_t l = 0; l < libs.size(); ++l)
+            for (size_t i = 0; i < lib_threads[l]; ++i)
+                NotifyMergeBuffer(libs[l].lib_index, i);
 
         INFO("Total " << counter << " reads processed");
-        NotifyStopProcessLibrary(lib_index);
+        for (const auto &lib : libs)
+            NotifyStopProcessLibrary(lib.lib_index);
     }
 
 private:
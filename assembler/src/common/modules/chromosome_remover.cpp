@@ -207,7 +207,7 @@ void ChromosomeRemover::ReferenceBasedRemoveChromosomal() {
 
     size_t deleted = 0;
     for (auto iter = graph.SmartEdgeBegin(); !iter.IsEnd(); ++iter) {
-        if (edge_pos.GetEdgePositions(*iter).size() == 0) {
+        if (!edge_pos.HasPositions(*iter)) {
             deleted++;
             graph.DeleteEdge(*iter);
         }
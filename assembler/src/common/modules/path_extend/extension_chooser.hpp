@@ -31,7 +31,7 @@ public:
     PathAnalyzer(const Graph& g): g_(g) {
     }
 
-    void RemoveTrivial(const BidirectionalPath& path, std::set<size_t>& to_exclude, bool exclude_bulges = true) const {
+    void RemoveTrivial(const BidirectionalPath& path, PathPositionSet& to_exclude, bool exclude_bulges = true) const {
         if (exclude_bulges) {
             ExcludeTrivialWithBulges(path, to_exclude);
         } else {
@@ -40,7 +40,7 @@ public:
     }
 
 protected:
-    virtual int ExcludeTrivial(const BidirectionalPath& path, std::set<size_t>& edges, int from = -1) const {
+    virtual int ExcludeTrivial(const BidirectionalPath& path, PathPositionSet& edges, int from = -1) const {
         int edgeIndex = (from == -1) ? (int) path.Size() - 1 : from;
         if ((int) path.Size() <= from) {
             return edgeIndex;
@@ -56,7 +56,7 @@ protected:
         return edgeIndex;
     }
 
-    virtual int ExcludeTrivialWithBulges(const BidirectionalPath& path, std::set<size_t>& edges) const {
+    virtual int ExcludeTrivialWithBulges(const BidirectionalPath& path, PathPositionSet& edges) const {
         if (path.Empty())
             return 0;
 
@@ -97,7 +97,7 @@ public:
     PreserveSimplePathsAnalyzer(const Graph &g)
             : PathAnalyzer(g) { }
 
-    int ExcludeTrivial(const BidirectionalPath& path, std::set<size_t>& edges, int from = -1) const override {
+    int ExcludeTrivial(const BidirectionalPath& path, PathPositionSet& edges, int from = -1) const override {
         int edgeIndex = PathAnalyzer::ExcludeTrivial(path, edges, from);
 
         //Preserving simple path
@@ -108,7 +108,7 @@ public:
         return edgeIndex;
     }
 
-    int ExcludeTrivialWithBulges(const BidirectionalPath& path, std::set<size_t>& edges) const override {
+    int ExcludeTrivialWithBulges(const BidirectionalPath& path, PathPositionSet& edges) const override {
         if (path.Empty())
             return 0;
 
@@ -400,8 +400,10 @@ private:
 class ExcludingExtensionChooser: public ExtensionChooser {
     PathAnalyzer analyzer_;
     double prior_coeff_;
+    // Reused across the calls of Filter(), see PathPositionSet
+    mutable PathPositionSet to_exclude_;
 
-    AlternativeContainer FindWeights(const BidirectionalPath& path, const EdgeContainer& edges, const std::set<size_t>& to_exclude) const {
+    AlternativeContainer FindWeights(const BidirectionalPath& path, const EdgeContainer& edges, const PathPositionSet& to_exclude) const {
         AlternativeContainer weights;
         for (auto iter = edges.begin(); iter != edges.end(); ++iter) {
             double weight = wc_->CountWeight(path, iter->e_, to_exclude);
@@ -423,7 +425,7 @@ class ExcludingExtensionChooser: public ExtensionChooser {
     }
 
     EdgeContainer FindFilteredEdges(const BidirectionalPath& path,
-            const EdgeContainer& edges, const std::set<size_t>& to_exclude) const {
+            const EdgeContainer& edges, const PathPositionSet& to_exclude) const {
         AlternativeContainer weights = FindWeights(path, edges, to_exclude);
         VERIFY(!weights.empty());
         auto max_weight = (--weights.end())->first;
@@ -440,7 +442,7 @@ protected:
 
     virtual void ExcludeEdges(const BidirectionalPath& path,
                               const EdgeContainer& /*edges*/,
-                              std::set<size_t>& to_exclude) const {
+                              PathPositionSet& to_exclude) const {
         analyzer_.RemoveTrivial(path, to_exclude);
     }
 
@@ -458,7 +460,8 @@ public:
         if (edges.empty()) {
             return edges;
         }
-        std::set<size_t> to_exclude;
+        auto &to_exclude = to_exclude_;
+        to_exclude.clear();
         path.PrintDEBUG();
         EdgeContainer result = edges;
         ExcludeEdges(path, result, to_exclude);
@@ -477,7 +480,7 @@ private:
 
 class SimpleExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const override {
+    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, PathPositionSet& to_exclude) const override {
         ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
 
         if (edges.size() < 2) {
@@ -505,17 +508,19 @@ protected:
         }
 
         //excluding based on presense of ambiguous paired info
-        std::map<size_t, unsigned> edge_2_extension_cnt;
+        auto &edge_2_extension_cnt = extension_cnt_;
+        edge_2_extension_cnt.assign(path.Size(), 0);
         for (size_t i = 0; i < edges.size(); ++i) {
-            for (size_t e : wc_->PairInfoExist(path, edges.at(i).e_)) {
+            wc_->PairInfoExist(path, edges.at(i).e_, supporting_);
+            for (size_t e : supporting_) {
                 edge_2_extension_cnt[e] += 1;
             }
         }
 
-        for (auto e_w_ec : edge_2_extension_cnt) {
-            if (e_w_ec.second == edges.size()) {
-                DEBUG("Excluding edge because of ambiguous paired info #" << e_w_ec.first)
-                to_exclude.insert(e_w_ec.first);
+        for (size_t e = 0; e < edge_2_extension_cnt.size(); ++e) {
+            if (edge_2_extension_cnt[e] == edges.size()) {
+                DEBUG("Excluding edge because of ambiguous paired info #" << e)
+                to_exclude.insert(e);
             }
         }
     }
@@ -527,6 +532,9 @@ public:
     }
 
 private:
+    mutable PathPositionSet supporting_;
+    mutable std::vector<size_t> extension_cnt_;
+
     DECL_LOGGER("SimpleExtensionChooser");
 };
 
@@ -534,7 +542,7 @@ private:
 class IdealBasedExtensionChooser : public ExcludingExtensionChooser {
 protected:
     void ExcludeEdges(const BidirectionalPath &path, const EdgeContainer &edges,
-                      std::set<size_t> &to_exclude) const override {
+                      PathPositionSet &to_exclude) const override {
         //commented for a reason
         //ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
         //if (edges.size() < 2) {
@@ -570,7 +578,7 @@ private:
 
 class RNAExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const override {
+    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, PathPositionSet& to_exclude) const override {
         ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
         if (edges.size() < 2) {
             return;
@@ -600,7 +608,7 @@ private:
 
 class LongEdgeExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    virtual void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const {
+    virtual void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, PathPositionSet& to_exclude) const {
         ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
         if (edges.size() < 2) {
             return;
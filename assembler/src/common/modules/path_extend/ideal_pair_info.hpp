@@ -8,8 +8,9 @@
 #pragma once
 
 #include "assembly_graph/core/graph.hpp"
-#include "adt/flat_map.hpp"
-#include <parallel_hashmap/phmap.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <utility>
 #include <vector>
 
@@ -25,39 +26,126 @@ public:
             : g_(g), k_(g_.k()),
               d_min_(d_min),
               d_max_(d_max),
-              read_size_(read_size) {
-        size_t sum = 0;
+              read_size_(read_size),
+              total_(0), is_min_(0) {
         for (const auto &entry : is_distribution)
-            sum += entry.second;
+            total_ += entry.second;
 
         auto left_bound = is_distribution.lower_bound(std::max(d_min_, 0));
         auto right_bound = is_distribution.upper_bound(d_max_);
 
-        for (auto it = left_bound; it != right_bound; ++it)
-            insert_size_distrib_[it->first] = double(it->second) / double(sum);
+        if (left_bound != right_bound) {
+            is_min_ = left_bound->first;
+            int is_max = std::prev(right_bound)->first;
+            counts_.assign(is_max - is_min_ + 1, 0);
+            for (auto it = left_bound; it != right_bound; ++it)
+                counts_[it->first - is_min_] = it->second;
+        }
+
+        // Prefix sums of the bin counts and of the counts weighted by the insert size,
+        // prefix_[i] covers the bins is_min_ .. is_min_ + i - 1
+        count_prefix_.assign(counts_.size() + 1, 0);
+        is_prefix_.assign(counts_.size() + 1, 0);
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            count_prefix_[i + 1] = count_prefix_[i] + int64_t(counts_[i]);
+            is_prefix_[i + 1] = is_prefix_[i] + int64_t(counts_[i]) * (is_min_ + int64_t(i));
+        }
 
         PreCalculateNotTotalReadsWeight();
     }
 
     double IdealPairedInfo(EdgeId e1, EdgeId e2, int dist, bool additive = false) const {
-        auto &weights = pi_[std::make_pair(g_.length(e1), g_.length(e2))];
-        auto entry = weights.insert(std::make_pair(dist, 0.));
-        if (entry.second)
-            entry.first->second = IdealPairedInfo(g_.length(e1), g_.length(e2), dist, additive);
-        return entry.first->second;
+        return IdealPairedInfo(g_.length(e1), g_.length(e2), dist, additive);
     }
 
+    // Note that the non-additive weight is computed exactly in integers and rounded
+    // once, while the old bin-by-bin summation rounded every p(is) * w term. So the
+    // results may differ from the old ones in the last bits (relative error ~1e-14).
     double IdealPairedInfo(size_t len1, size_t len2, int dist, bool additive = false) const {
+        if (!total_)
+            return 0.0;
+        if (additive)
+            return AdditivePairedInfo(len1, len2, dist);
+
+        // Sum over the insert sizes of p(is) * IdealReads(is). Without the partial weights
+        // IdealReads() is max(0, min(is + alpha, plateau, beta - is)) (and just linear in
+        // the insert size for zero distance), so the sum is computed from the prefix sums
+        // over at most three ranges of insert sizes.
+        int64_t l1 = (int64_t) len1, l2 = (int64_t) len2;
+        int64_t k = (int64_t) k_, rs = (int64_t) read_size_;
+        if (dist == 0)
+            return double(WeightedSum(INT64_MIN, INT64_MAX, -1, l1 + 2 * rs - 2 - k + 1)) / double(total_);
+
+        int64_t alpha, plateau, beta;
+        if (!Shape(len1, len2, dist, alpha, plateau, beta))
+            return 0.0;
+
+        int64_t rise_end = std::min(plateau - alpha, FloorDiv(beta - alpha, 2));
+        int64_t fall_start = std::max(beta - plateau, rise_end + 1);
+        int64_t sum = WeightedSum(1 - alpha, rise_end, 1, alpha) +
+                      WeightedSum(rise_end + 1, fall_start - 1, 0, plateau) +
+                      WeightedSum(fall_start, beta - 1, -1, beta);
+        return double(sum) / double(total_);
+    }
+
+private:
+    static int64_t FloorDiv(int64_t a, int64_t b) {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    }
+
+    // For a non-zero distance the number of reads is max(0, min(is + alpha, plateau, beta - is)),
+    // see IdealReads(). Returns false if it is zero for all insert sizes.
+    bool Shape(size_t len1, size_t len2, int dist,
+               int64_t &alpha, int64_t &plateau, int64_t &beta) const {
+        int64_t l1 = (int64_t) len1, l2 = (int64_t) len2;
+        int64_t k = (int64_t) k_, rs = (int64_t) read_size_;
+        if (dist < 0) {
+            std::swap(l1, l2);
+            dist = -dist;
+        }
+
+        int64_t gap_len = dist - l1;
+        int64_t left_short = gap_len + k + 1 - rs;
+        int64_t right_short = gap_len + l2 - 1;
+        // right - left + 1 is the minimum of these four, see IdealReads()
+        alpha = -rs - left_short;
+        plateau = std::min(rs + l1 - k - 1, right_short - left_short + 1);
+        beta = right_short + 2 * rs + l1 - k;
+        return plateau > 0 && 1 - alpha <= beta - 1;
+    }
+
+    // Sum of count(is) * (slope * is + shift) over the insert sizes in [from, to]
+    int64_t WeightedSum(int64_t from, int64_t to, int64_t slope, int64_t shift) const {
+        from = std::max(from, (int64_t) is_min_);
+        to = std::min(to, (int64_t) is_min_ + (int64_t) counts_.size() - 1);
+        if (from > to)
+            return 0;
+        size_t b = size_t(from - is_min_), e = size_t(to - is_min_ + 1);
+        return slope * (is_prefix_[e] - is_prefix_[b]) + shift * (count_prefix_[e] - count_prefix_[b]);
+    }
+
+    // The partial weights of the reads overlapping the edge ends are not linear in
+    // the insert size, so this one is summed bin by bin, in the order of increasing
+    // insert size. The bins outside of the non-zero range only add exact zeros.
+    double AdditivePairedInfo(size_t len1, size_t len2, int dist) const {
+        int64_t from = is_min_, to = is_min_ + (int64_t) counts_.size() - 1;
+        if (dist != 0) {
+            int64_t alpha, plateau, beta;
+            if (!Shape(len1, len2, dist, alpha, plateau, beta))
+                return 0.0;
+            from = std::max(from, 1 - alpha);
+            to = std::min(to, beta - 1);
+        }
+
         double result = 0.0;
-        for (const auto &entry : insert_size_distrib_) {
-            if (entry.second > 0)
-                result += entry.second * (double) IdealReads(len1, len2, dist, entry.first, additive);
+        for (int64_t is = from; is <= to; ++is) {
+            double p = double(counts_[size_t(is - is_min_)]) / double(total_);
+            if (p > 0)
+                result += p * (double) IdealReads(len1, len2, dist, size_t(is), true);
         }
         return result;
     }
 
-private:
-
     double IdealReads(size_t len1_1, size_t len2_1, int dist,
                       size_t is_1, bool additive) const {
         int len1 = (int) len1_1;
@@ -110,20 +198,13 @@ private:
     const int d_max_;
     size_t read_size_;
 
-    using InsertSizeMap = adt::flat_map<int, double>;
-    InsertSizeMap insert_size_distrib_;
+    size_t total_;
+    int is_min_;
+    std::vector<size_t> counts_;
+    std::vector<int64_t> count_prefix_;
+    std::vector<int64_t> is_prefix_;
     std::vector<double> not_total_weights_right_;
     std::vector<double> not_total_weights_left_;
-
-    struct PairHash {
-        size_t operator()(std::pair<size_t, size_t> pair) const {
-            return phmap::HashState().combine(0, pair.first, pair.second);
-        }
-    };
-
-    mutable phmap::parallel_node_hash_map<std::pair<size_t, size_t>,
-                                          phmap::flat_hash_map<int, double>,
-                                          PairHash> pi_;
 protected:
     DECL_LOGGER("PathExtendPI");
 };
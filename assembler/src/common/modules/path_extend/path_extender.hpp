@@ -234,7 +234,7 @@ private:
         // FIXME: rethink logic
         auto cycle = BidirectionalPath::create(g_, back_cycle_edge);
         while (cycle->Length() < is + g_.length(back_cycle_edge)) {
-            auto w = wc_->CountWeight(*cycle, back_cycle_edge, std::set<size_t>(), forward_len);
+            auto w = wc_->CountWeight(*cycle, back_cycle_edge, PathPositionSet(), forward_len);
             if (math::gr(w, weight_threshold_)) {
                 //Paired information found within loop
                 DEBUG("Found PI with back weight " << w << ", weight threshold " << weight_threshold_);
@@ -233,13 +233,22 @@ AssemblyGraphConnectionCondition::AssemblyGraphConnectionCondition(const debruij
 Connections AssemblyGraphConnectionCondition::ConnectedWith(debruijn_graph::EdgeId e) const {
     VERIFY_MSG(interesting_edge_set_.find(e) != interesting_edge_set_.end(),
                " edge "<< e.int_id() << " not applicable for connection condition");
-    if (stored_distances_.find(e) != stored_distances_.end()) {
-        return stored_distances_[e];
+    bool stored = false;
+    Connections res;
+    #pragma omp critical(assembly_graph_connection_cache)
+    {
+        auto it = stored_distances_.find(e);
+        if (it != stored_distances_.end()) {
+            res = it->second;
+            stored = true;
+        }
     }
-    stored_distances_.emplace(e, Connections());
+    if (stored)
+        return res;
+
     for (auto connected: g_.OutgoingEdges(g_.EdgeEnd(e))) {
         if (interesting_edge_set_.find(connected) != interesting_edge_set_.end()) {
-            stored_distances_[e].emplace(connected, 1);
+            res.emplace(connected, 1);
         }
     }
     auto dijkstra = omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_, max_connection_length_);
@@ -247,11 +256,15 @@ Connections AssemblyGraphConnectionCondition::ConnectedWith(debruijn_graph::Edge
     for (auto v: dijkstra.ReachedVertices()) {
         for (auto connected: g_.OutgoingEdges(v)) {
             if (interesting_edge_set_.find(connected) != interesting_edge_set_.end() && dijkstra.GetDistance(v) < max_connection_length_) {
-                stored_distances_[e].emplace(connected, 1);
+                res.emplace(connected, 1);
             }
         }
     }
-    return stored_distances_[e];
+    #pragma omp critical(assembly_graph_connection_cache)
+    {
+        stored_distances_.emplace(e, res);
+    }
+    return res;
 }
 void AssemblyGraphConnectionCondition::AddInterestingEdges(func::TypedPredicate<typename Graph::EdgeId> edge_condition) {
     for (EdgeId e : g_.edges()) {
@@ -1,41 +1,56 @@
 #include "scaffold_graph.hpp"
 
+#include <algorithm>
+
 
 namespace path_extend {
 namespace scaffold_graph {
 
 std::atomic<ScaffoldGraph::ScaffoldEdgeIdT> ScaffoldGraph::ScaffoldEdge::scaffold_edge_id_{0};
 
+const ScaffoldGraph::EdgeIdList &ScaffoldGraph::AdjacentEdges(const AdjacencyStorage &adjacency,
+                                                               ScaffoldGraph::ScaffoldVertex v) {
+    static const EdgeIdList empty;
+    auto it = adjacency.find(v);
+    return it == adjacency.end() ? empty : it->second;
+}
+
+void ScaffoldGraph::DeleteAdjacent(AdjacencyStorage &adjacency, ScaffoldGraph::ScaffoldVertex v,
+                                   const ScaffoldGraph::ScaffoldEdge &e) {
+    auto it = adjacency.find(v);
+    if (it == adjacency.end())
+        return;
+    EdgeIdList &ids = it->second;
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+                             [&](ScaffoldEdgeIdT id) { return edges_.at(id) == e; }),
+              ids.end());
+    if (ids.empty())
+        adjacency.erase(it);
+}
+
 void ScaffoldGraph::AddEdgeSimple(const ScaffoldGraph::ScaffoldEdge &e) {
     edges_.emplace(e.getId(), e);
-    outgoing_edges_.emplace(e.getStart(), e.getId());
-    incoming_edges_.emplace(e.getEnd(), e.getId());
+    outgoing_edges_[e.getStart()].push_back(e.getId());
+    incoming_edges_[e.getEnd()].push_back(e.getId());
 }
 
 void ScaffoldGraph::DeleteOutgoing(const ScaffoldGraph::ScaffoldEdge &e) {
-    auto e_range = outgoing_edges_.equal_range(e.getStart());
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        if (edges_.at(edge_id->second) == e) {
-            outgoing_edges_.erase(edge_id);
-        }
-    }
+    DeleteAdjacent(outgoing_edges_, e.getStart(), e);
 }
 
 void ScaffoldGraph::DeleteIncoming(const ScaffoldGraph::ScaffoldEdge &e) {
-    auto e_range = incoming_edges_.equal_range(e.getEnd());
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        if (edges_.at(edge_id->second) == e) {
-            incoming_edges_.erase(edge_id);
-        }
-    }
+    DeleteAdjacent(incoming_edges_, e.getEnd(), e);
 }
 
 void ScaffoldGraph::DeleteAllOutgoingEdgesSimple(ScaffoldGraph::ScaffoldVertex v) {
-    auto e_range = outgoing_edges_.equal_range(v);
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        DeleteIncoming(edges_.at(edge_id->second));
+    auto it = outgoing_edges_.find(v);
+    if (it == outgoing_edges_.end())
+        return;
+    EdgeIdList ids = std::move(it->second);
+    outgoing_edges_.erase(it);
+    for (ScaffoldEdgeIdT id : ids) {
+        DeleteIncoming(edges_.at(id));
     }
-    outgoing_edges_.erase(v);
 }
 
 void ScaffoldGraph::DeleteEdgeFromStorage(const ScaffoldGraph::ScaffoldEdge &e) {
@@ -44,11 +59,14 @@ void ScaffoldGraph::DeleteEdgeFromStorage(const ScaffoldGraph::ScaffoldEdge &e)
 }
 
 void ScaffoldGraph::DeleteAllIncomingEdgesSimple(ScaffoldGraph::ScaffoldVertex v) {
-    auto e_range = incoming_edges_.equal_range(v);
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        DeleteOutgoing(edges_.at(edge_id->second));
+    auto it = incoming_edges_.find(v);
+    if (it == incoming_edges_.end())
+        return;
+    EdgeIdList ids = std::move(it->second);
+    incoming_edges_.erase(it);
+    for (ScaffoldEdgeIdT id : ids) {
+        DeleteOutgoing(edges_.at(id));
     }
-    incoming_edges_.erase(v);
 }
 
 bool ScaffoldGraph::Exists(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
@@ -56,9 +74,8 @@ bool ScaffoldGraph::Exists(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) co
 }
 
 bool ScaffoldGraph::Exists(const ScaffoldGraph::ScaffoldEdge &e) const {
-    auto e_range = outgoing_edges_.equal_range(e.getStart());
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        if (edges_.at(edge_id->second) == e) {
+    for (ScaffoldEdgeIdT id : AdjacentEdges(outgoing_edges_, e.getStart())) {
+        if (edges_.at(id) == e) {
             return true;
         }
     }
@@ -104,25 +121,34 @@ bool ScaffoldGraph::AddEdge(ScaffoldGraph::ScaffoldVertex v1, ScaffoldGraph::Sca
 }
 
 void ScaffoldGraph::Print(std::ostream &os) const {
-    for (auto v: vertices_) {
+    //Hash storages are unordered, sort for the stable output
+    std::vector<ScaffoldVertex> vertices(vertices_.begin(), vertices_.end());
+    std::sort(vertices.begin(), vertices.end());
+    for (auto v: vertices) {
         os << "Vertex " << int_id(v) << " ~ " << int_id(conjugate(v))
             << ": len = " << assembly_graph_.length(v) << ", cov = " << assembly_graph_.coverage(v) << std::endl;
     }
-    for (auto e_iter = edges_.begin(); e_iter != edges_.end(); ++e_iter) {
-        os << "Edge " << e_iter->second.getId() <<
-            ": " << int_id(e_iter->second.getStart()) << " -> " << int_id(e_iter->second.getEnd()) <<
-            ", lib index = " << e_iter->second.getColor() << ", weight " << e_iter->second.getWeight() << std::endl;
+    std::vector<ScaffoldEdgeIdT> edge_ids;
+    edge_ids.reserve(edges_.size());
+    for (const auto &entry : edges_)
+        edge_ids.push_back(entry.first);
+    std::sort(edge_ids.begin(), edge_ids.end());
+    for (ScaffoldEdgeIdT id : edge_ids) {
+        const ScaffoldEdge &e = edges_.at(id);
+        os << "Edge " << e.getId() <<
+            ": " << int_id(e.getStart()) << " -> " << int_id(e.getEnd()) <<
+            ", lib index = " << e.getColor() << ", weight " << e.getWeight() << std::endl;
     }
 }
 
 ScaffoldGraph::ScaffoldEdge ScaffoldGraph::UniqueIncoming(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
     VERIFY(HasUniqueIncoming(assembly_graph_edge));
-    return edges_.at(incoming_edges_.find(assembly_graph_edge)->second);
+    return edges_.at(AdjacentEdges(incoming_edges_, assembly_graph_edge).front());
 }
 
 ScaffoldGraph::ScaffoldEdge ScaffoldGraph::UniqueOutgoing(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
     VERIFY(HasUniqueOutgoing(assembly_graph_edge));
-    return edges_.at(outgoing_edges_.find(assembly_graph_edge)->second);
+    return edges_.at(AdjacentEdges(outgoing_edges_, assembly_graph_edge).front());
 }
 
 bool ScaffoldGraph::HasUniqueIncoming(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
@@ -134,27 +160,25 @@ bool ScaffoldGraph::HasUniqueOutgoing(ScaffoldGraph::ScaffoldVertex assembly_gra
 }
 
 size_t ScaffoldGraph::IncomingEdgeCount(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
-    return incoming_edges_.count(assembly_graph_edge);
+    return AdjacentEdges(incoming_edges_, assembly_graph_edge).size();
 }
 
 size_t ScaffoldGraph::OutgoingEdgeCount(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
-    return outgoing_edges_.count(assembly_graph_edge);
+    return AdjacentEdges(outgoing_edges_, assembly_graph_edge).size();
 }
 
 std::vector<ScaffoldGraph::ScaffoldEdge> ScaffoldGraph::IncomingEdges(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
     std::vector<ScaffoldEdge> result;
-    auto e_range = incoming_edges_.equal_range(assembly_graph_edge);
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        result.push_back(edges_.at(edge_id->second));
+    for (ScaffoldEdgeIdT id : AdjacentEdges(incoming_edges_, assembly_graph_edge)) {
+        result.push_back(edges_.at(id));
     }
     return result;
 }
 
 std::vector<ScaffoldGraph::ScaffoldEdge> ScaffoldGraph::OutgoingEdges(ScaffoldGraph::ScaffoldVertex assembly_graph_edge) const {
     std::vector<ScaffoldEdge> result;
-    auto e_range = outgoing_edges_.equal_range(assembly_graph_edge);
-    for (auto edge_id = e_range.first; edge_id != e_range.second; ++edge_id) {
-        result.push_back(edges_.at(edge_id->second));
+    for (ScaffoldEdgeIdT id : AdjacentEdges(outgoing_edges_, assembly_graph_edge)) {
+        result.push_back(edges_.at(id));
     }
     return result;
 }
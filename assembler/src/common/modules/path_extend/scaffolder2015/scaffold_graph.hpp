@@ -9,6 +9,8 @@
 #include "connection_condition2015.hpp"
 #include "adt/iterator_range.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace path_extend {
 namespace scaffold_graph {
 
@@ -81,12 +83,13 @@ public:
     typedef ScaffoldVertex VertexId;
     typedef ScaffoldEdge EdgeId;
 
-    //All vertices are stored in set
-    typedef std::set<ScaffoldVertex> VertexStorage;
+    //All vertices are stored in hash set, iteration order is arbitrary
+    typedef phmap::flat_hash_set<ScaffoldVertex> VertexStorage;
     //Edges are stored in map: Id -> Edge Information
-    typedef std::unordered_map<ScaffoldEdgeIdT, ScaffoldEdge> EdgeStorage;
-    //Adjacency list contains vertrx and edge id (instead of whole edge information)
-    typedef std::unordered_multimap<ScaffoldVertex, ScaffoldEdgeIdT> AdjacencyStorage;
+    typedef phmap::flat_hash_map<ScaffoldEdgeIdT, ScaffoldEdge> EdgeStorage;
+    //Adjacency list contains vertex and ids of its edges (instead of whole edge information)
+    typedef std::vector<ScaffoldEdgeIdT> EdgeIdList;
+    typedef phmap::flat_hash_map<ScaffoldVertex, EdgeIdList> AdjacencyStorage;
 
     struct ConstScaffoldEdgeIterator: public boost::iterator_facade<ConstScaffoldEdgeIterator,
                                                                     const ScaffoldEdge,
@@ -126,6 +129,12 @@ private:
 
     AdjacencyStorage incoming_edges_;
 
+    //Ids of edges adjacent to v, empty list if there are none
+    static const EdgeIdList &AdjacentEdges(const AdjacencyStorage &adjacency, ScaffoldVertex v);
+
+    //Delete edge with the same information as e from adjacency list of v
+    void DeleteAdjacent(AdjacencyStorage &adjacency, ScaffoldVertex v, const ScaffoldEdge &e);
+
     void AddEdgeSimple(const ScaffoldEdge &e);
 
     //Delete outgoing edge from adjancecy list without checks
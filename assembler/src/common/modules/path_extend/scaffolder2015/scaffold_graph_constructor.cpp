@@ -4,6 +4,10 @@
 
 #include "scaffold_graph_constructor.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+
 namespace path_extend {
 
 namespace scaffold_graph {
@@ -39,21 +43,45 @@ void BaseScaffoldGraphConstructor::ConstructFromConditions(ConnectionConditions
 
 void BaseScaffoldGraphConstructor::ConstructFromSingleCondition(const std::shared_ptr<ConnectionCondition> condition,
                                                                 bool use_terminal_vertices_only) {
-    for (const auto& v : graph_->vertices()) {
-        TRACE("Vertex " << graph_->int_id(v));
-
-        if (use_terminal_vertices_only && graph_->OutgoingEdgeCount(v) > 0)
-            continue;
-
-        auto connected_with = condition->ConnectedWith(v);
-        for (const auto& pair : connected_with) {
-            EdgeId connected = pair.first;
-            double w = pair.second;
-            TRACE("Connected with " << graph_->int_id(connected));
-            if (graph_->Exists(connected)) {
-                if (use_terminal_vertices_only && graph_->IncomingEdgeCount(connected) > 0)
-                    continue;
-                graph_->AddEdge(v, connected, condition->GetLibIndex(), w);
+    //Terminal vertex checks depend on the edges added before, so the vertices are processed in the fixed order
+    std::vector<ScaffoldGraph::ScaffoldVertex> vertices(graph_->vbegin(), graph_->vend());
+    std::sort(vertices.begin(), vertices.end());
+
+    //Connections are evaluated in parallel chunk by chunk, while edges are added sequentially in the vertex order,
+    //so the resulting graph does not depend on the number of threads
+    const size_t chunk_size = 1 << 14;
+    std::vector<std::vector<std::pair<EdgeId, double>>> connections;
+    for (size_t start = 0; start < vertices.size(); start += chunk_size) {
+        size_t end = std::min(vertices.size(), start + chunk_size);
+        connections.assign(end - start, {});
+
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t i = start; i < end; ++i) {
+            ScaffoldGraph::ScaffoldVertex v = vertices[i];
+            //Terminal vertex can only lose this property, so it is safe to skip it early
+            if (use_terminal_vertices_only && graph_->OutgoingEdgeCount(v) > 0)
+                continue;
+
+            auto connected_with = condition->ConnectedWith(v);
+            connections[i - start].assign(connected_with.begin(), connected_with.end());
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            ScaffoldGraph::ScaffoldVertex v = vertices[i];
+            TRACE("Vertex " << graph_->int_id(v));
+
+            if (use_terminal_vertices_only && graph_->OutgoingEdgeCount(v) > 0)
+                continue;
+
+            for (const auto& pair : connections[i - start]) {
+                EdgeId connected = pair.first;
+                double w = pair.second;
+                TRACE("Connected with " << graph_->int_id(connected));
+                if (graph_->Exists(connected)) {
+                    if (use_terminal_vertices_only && graph_->IncomingEdgeCount(connected) > 0)
+                        continue;
+                    graph_->AddEdge(v, connected, condition->GetLibIndex(), w);
+                }
             }
         }
     }
@@ -11,6 +11,8 @@
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "paired_library.hpp"
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 
 namespace path_extend {
 
@@ -49,6 +51,90 @@ struct EdgeWithPairedInfo {
     }
 };
 
+/**
+ * @brief  Set of positions of a path stored as a bitset. clear() keeps the storage, so
+ *         an instance reused across the extension steps stops allocating as soon as it
+ *         has grown to the path size.
+ */
+class PathPositionSet {
+public:
+    typedef size_t value_type;
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef size_t value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const size_t* pointer;
+        typedef size_t reference;
+
+        const_iterator(const std::vector<uint64_t> &words, size_t pos)
+                : words_(&words), pos_(pos) {
+            Advance();
+        }
+
+        size_t operator*() const { return pos_; }
+
+        const_iterator &operator++() {
+            ++pos_;
+            Advance();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const const_iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        // Moves to the first set position not less than the current one
+        void Advance() {
+            size_t end = words_->size() * 64;
+            while (pos_ < end) {
+                uint64_t rest = (*words_)[pos_ / 64] >> (pos_ % 64);
+                if (rest) {
+                    pos_ += __builtin_ctzll(rest);
+                    return;
+                }
+                pos_ = (pos_ / 64 + 1) * 64;
+            }
+            pos_ = end;
+        }
+
+        const std::vector<uint64_t> *words_;
+        size_t pos_;
+    };
+
+    void insert(size_t pos) {
+        if (pos / 64 >= words_.size())
+            words_.resize(pos / 64 + 1, 0);
+        words_[pos / 64] |= uint64_t(1) << (pos % 64);
+    }
+
+    size_t count(size_t pos) const {
+        return pos / 64 < words_.size() && (words_[pos / 64] >> (pos % 64) & 1);
+    }
+
+    void clear() {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+    bool empty() const {
+        return std::all_of(words_.begin(), words_.end(), [](uint64_t w) { return w == 0; });
+    }
+
+    size_t size() const {
+        size_t res = 0;
+        for (uint64_t w : words_)
+            res += __builtin_popcountll(w);
+        return res;
+    }
+
+    const_iterator begin() const { return const_iterator(words_, 0); }
+    const_iterator end() const { return const_iterator(words_, words_.size() * 64); }
+
+private:
+    std::vector<uint64_t> words_;
+};
+
 struct EdgeWithDistance {
     using GapSeqType = std::unique_ptr<std::string>;
     EdgeId e_;
@@ -98,8 +184,9 @@ class IdealInfoProvider {
 public:
     virtual ~IdealInfoProvider() {}
 
-    virtual std::vector<EdgeWithPairedInfo> FindCoveredEdges(const BidirectionalPath &path,
-                                                             EdgeId candidate, int gap = 0) const = 0;
+    // Fills covered with the path positions ideally covered by the paired info with the candidate
+    virtual void FindCoveredEdges(const BidirectionalPath &path, EdgeId candidate, int gap,
+                                  std::vector<EdgeWithPairedInfo> &covered) const = 0;
 protected:
     DECL_LOGGER("IdealInfoProvider");
 };
@@ -110,9 +197,9 @@ public:
     BasicIdealInfoProvider(const std::shared_ptr<PairedInfoLibrary> &lib) : lib_(lib) {
     }
 
-    std::vector<EdgeWithPairedInfo> FindCoveredEdges(const BidirectionalPath &path,
-                                                     EdgeId candidate, int gap) const override {
-        std::vector<EdgeWithPairedInfo> covered;
+    void FindCoveredEdges(const BidirectionalPath &path, EdgeId candidate, int gap,
+                          std::vector<EdgeWithPairedInfo> &covered) const override {
+        covered.clear();
         for (int i = (int) path.Size() - 1; i >= 0; --i) {
             double w = lib_->IdealPairedInfo(path[i], candidate,
                                             (int) path.LengthAt(i) + gap);
@@ -121,7 +208,6 @@ public:
                 covered.push_back(EdgeWithPairedInfo(i, w));
             }
         }
-        return covered;
     }
 };
 
@@ -133,6 +219,10 @@ protected:
     bool normalize_weight_;
     std::shared_ptr<IdealInfoProvider> ideal_provider_;
 
+    // Scratch buffers reused by every query, the extension is single-threaded
+    mutable std::vector<EdgeWithPairedInfo> ideal_coverage_;
+    mutable std::vector<EdgeWithPairedInfo> lib_coverage_;
+
 public:
     WeightCounter(const Graph &g, std::shared_ptr<PairedInfoLibrary> lib,
                   bool normalize_weight = true,
@@ -145,11 +235,13 @@ public:
 
     virtual ~WeightCounter() = default;
 
-    virtual std::set<size_t> PairInfoExist(const BidirectionalPath &path, EdgeId e,
-                                           int gap = 0) const = 0;
+    // Fills supporting with the path positions having paired info with e
+    virtual void PairInfoExist(const BidirectionalPath &path, EdgeId e,
+                               PathPositionSet &supporting, int gap = 0) const = 0;
 
     virtual double CountWeight(const BidirectionalPath &path, EdgeId e,
-                               const std::set<size_t> &excluded_edges = {}, int gapLength = 0) const = 0;
+                               const PathPositionSet &excluded_edges = PathPositionSet(),
+                               int gapLength = 0) const = 0;
 
     const PairedInfoLibrary& PairedLibrary() const {
         return *lib_;
@@ -161,11 +253,13 @@ protected:
 
 class ReadCountWeightCounter: public WeightCounter {
 
-    std::vector<EdgeWithPairedInfo> CountLib(const BidirectionalPath &path, EdgeId e,
-                                             int add_gap = 0) const {
-        std::vector<EdgeWithPairedInfo> answer;
+    const std::vector<EdgeWithPairedInfo> &CountLib(const BidirectionalPath &path, EdgeId e,
+                                                    int add_gap = 0) const {
+        auto &answer = lib_coverage_;
+        answer.clear();
 
-        for (const EdgeWithPairedInfo& e_w_pi : ideal_provider_->FindCoveredEdges(path, e, add_gap)) {
+        ideal_provider_->FindCoveredEdges(path, e, add_gap, ideal_coverage_);
+        for (const EdgeWithPairedInfo& e_w_pi : ideal_coverage_) {
             double w = lib_->CountPairedInfo(path[e_w_pi.e_], e,
                     (int) path.LengthAt(e_w_pi.e_) + add_gap);
 
@@ -187,7 +281,7 @@ public:
     }
 
     double CountWeight(const BidirectionalPath &path, EdgeId e,
-                       const std::set<size_t> &excluded_edges, int gap) const override {
+                       const PathPositionSet &excluded_edges, int gap) const override {
         double weight = 0.0;
 
         for (const auto& e_w_pi : CountLib(path, e, gap)) {
@@ -199,16 +293,14 @@ public:
         return weight;
     }
 
-    std::set<size_t> PairInfoExist(const BidirectionalPath &path, EdgeId e,
-                                   int gap = 0) const override {
-        std::set<size_t> answer;
+    void PairInfoExist(const BidirectionalPath &path, EdgeId e,
+                       PathPositionSet &supporting, int gap = 0) const override {
+        supporting.clear();
         for (const auto& e_w_pi : CountLib(path, e, gap)) {
             if (math::gr(e_w_pi.pi_, 0.)) {
-                answer.insert(e_w_pi.e_);
+                supporting.insert(e_w_pi.e_);
             }
         }
-        
-        return answer;
     }
 
     virtual ~ReadCountWeightCounter() = default;
@@ -218,7 +310,7 @@ class PathCoverWeightCounter: public WeightCounter {
     double single_threshold_;
 
     double TotalIdealNonExcluded(const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
-                                 const std::set<size_t> &excluded_edges) const {
+                                 const PathPositionSet &excluded_edges) const {
         double ideal_total = 0.0;
 
         for (const EdgeWithPairedInfo& e_w_pi : ideally_covered_edges) {
@@ -229,10 +321,11 @@ class PathCoverWeightCounter: public WeightCounter {
         return ideal_total;
     }
 
-    std::vector<EdgeWithPairedInfo> CountLib(const BidirectionalPath &path, EdgeId e,
-                                             const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
-                                             int add_gap = 0) const {
-        std::vector<EdgeWithPairedInfo> answer;
+    const std::vector<EdgeWithPairedInfo> &CountLib(const BidirectionalPath &path, EdgeId e,
+                                                    const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
+                                                    int add_gap = 0) const {
+        auto &answer = lib_coverage_;
+        answer.clear();
 
         for (const auto& e_w_pi : ideally_covered_edges) {
             double ideal_weight = e_w_pi.pi_;
@@ -275,10 +368,11 @@ public:
     }
 
     double CountWeight(const BidirectionalPath &path, EdgeId e,
-                       const std::set<size_t> &excluded_edges, int gap) const override {
+                       const PathPositionSet &excluded_edges, int gap) const override {
         TRACE("Counting weight for edge " << g_.str(e));
         double lib_weight = 0.;
-        const auto ideal_coverage = ideal_provider_->FindCoveredEdges(path, e, gap);
+        ideal_provider_->FindCoveredEdges(path, e, gap, ideal_coverage_);
+        const auto &ideal_coverage = ideal_coverage_;
 
         for (const auto& e_w_pi : CountLib(path, e, ideal_coverage, gap)) {
             if (!excluded_edges.count(e_w_pi.e_)) {
@@ -295,15 +389,15 @@ public:
         return math::eq(total_ideal_coverage, 0.) ? 0. : lib_weight / total_ideal_coverage;
     }
 
-    std::set<size_t> PairInfoExist(const BidirectionalPath& path, EdgeId e, 
-                                    int gap = 0) const override {
-        std::set<size_t> answer;
-        for (const auto& e_w_pi : CountLib(path, e, ideal_provider_->FindCoveredEdges(path, e, gap), gap)) {
+    void PairInfoExist(const BidirectionalPath& path, EdgeId e,
+                       PathPositionSet &supporting, int gap = 0) const override {
+        supporting.clear();
+        ideal_provider_->FindCoveredEdges(path, e, gap, ideal_coverage_);
+        for (const auto& e_w_pi : CountLib(path, e, ideal_coverage_, gap)) {
             if (math::gr(e_w_pi.pi_, 0.)) {
-                answer.insert(e_w_pi.e_);
+                supporting.insert(e_w_pi.e_);
             }
         }
-        return answer;
     }
 
     virtual ~PathCoverWeightCounter() = default;
@@ -330,7 +424,8 @@ public:
                 BasicIdealInfoProvider(lib), g_(g), read_length_(read_length) {}
 
     //TODO optimize number of calls of EstimatePathCoverage(path)
-    std::vector<EdgeWithPairedInfo> FindCoveredEdges(const BidirectionalPath &path, EdgeId candidate, int gap) const override {
+    void FindCoveredEdges(const BidirectionalPath &path, EdgeId candidate, int gap,
+                          std::vector<EdgeWithPairedInfo> &covered) const override {
         VERIFY(read_length_ != -1ul);
         //bypassing problems with ultra-low coverage estimates
         double estimated_coverage = std::max(EstimatePathCoverage(path), 1.0);
@@ -340,11 +435,10 @@ public:
         TRACE("Estimated coverage " << estimated_coverage);
         TRACE("Correction coefficient " << correction_coeff);
 
-        std::vector<EdgeWithPairedInfo> answer = BasicIdealInfoProvider::FindCoveredEdges(path, candidate, gap);
-        for (auto& e_w_pi : answer) {
+        BasicIdealInfoProvider::FindCoveredEdges(path, candidate, gap, covered);
+        for (auto& e_w_pi : covered) {
             e_w_pi.pi_ *= correction_coeff;
         }
-        return answer;
     }
 };
 
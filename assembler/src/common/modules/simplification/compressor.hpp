@@ -1,6 +1,11 @@
 #pragma once
 #include "assembly_graph/graph_support/parallel_processing.hpp"
 #include "assembly_graph/graph_support/basic_vertex_conditions.hpp"
+#include "assembly_graph/core/action_handlers.hpp"
+
+#include <parallel_hashmap/phmap.h>
+#include <algorithm>
+
 namespace omnigraph {
 
 /**
@@ -92,6 +97,81 @@ private:
     DECL_LOGGER("Compressor")
 };
 
+/**
+* Records vertices whose degree was changed by graph modifications since the last compression,
+* so that the following compression could only look at them instead of scanning the whole graph.
+* Compressible vertices which existed before the tracker was attached are not recorded.
+*/
+template<class Graph>
+class DirtyVertexTracker : public GraphActionHandler<Graph> {
+    typedef GraphActionHandler<Graph> base;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+
+    phmap::flat_hash_set<VertexId> dirty_;
+
+    void TouchEnds(EdgeId e) {
+        dirty_.insert(this->g().EdgeStart(e));
+        dirty_.insert(this->g().EdgeEnd(e));
+    }
+
+public:
+    DirtyVertexTracker(const Graph &g)
+            : base(g, "DirtyVertexTracker") {}
+
+    void HandleAdd(VertexId v) override {
+        dirty_.insert(v);
+    }
+
+    void HandleAdd(EdgeId e) override {
+        TouchEnds(e);
+    }
+
+    void HandleDelete(VertexId v) override {
+        dirty_.erase(v);
+    }
+
+    void HandleDelete(EdgeId e) override {
+        TouchEnds(e);
+    }
+
+    size_t size() const {
+        return dirty_.size();
+    }
+
+    // Returns the recorded vertices in a deterministic order and forgets them
+    std::vector<VertexId> Release() {
+        std::vector<VertexId> res(dirty_.begin(), dirty_.end());
+        std::sort(res.begin(), res.end());
+        dirty_.clear();
+        return res;
+    }
+
+    void clear() {
+        dirty_.clear();
+    }
+};
+
+template<class Graph>
+class DirtyVertexFinder : public InterestingElementFinder<Graph, typename Graph::VertexId> {
+    typedef typename Graph::VertexId VertexId;
+    typedef InterestingElementFinder<Graph, VertexId> base;
+    typedef typename base::HandlerF HandlerF;
+
+    DirtyVertexTracker<Graph> &tracker_;
+public:
+    DirtyVertexFinder(func::TypedPredicate<VertexId> condition, DirtyVertexTracker<Graph> &tracker)
+            : base(condition), tracker_(tracker) {}
+
+    bool Run(const Graph &/*g*/, HandlerF handler) const override {
+        for (VertexId v : tracker_.Release()) {
+            if (this->condition_(v))
+                handler(v);
+        }
+        return false;
+    }
+};
+
 template<class Graph>
 class CompressingProcessor : public PersistentProcessingAlgorithm<Graph, typename Graph::VertexId> {
     typedef typename Graph::EdgeId EdgeId;
@@ -108,6 +188,13 @@ public:
             compressor_(graph, safe_merging) {
     }
 
+    CompressingProcessor(Graph &graph, DirtyVertexTracker<Graph> &tracker, bool safe_merging = true) :
+            base(graph,
+                 std::make_shared<DirtyVertexFinder<Graph>>(ConditionT(graph), tracker),
+                    /*canonical only*/true),
+            compressor_(graph, safe_merging) {
+    }
+
 protected:
     bool Process(VertexId v) override {
         return compressor_.CompressVertex(v);
@@ -120,6 +207,29 @@ protected:
 template<class Graph>
 size_t CompressAllVertices(Graph &g, size_t chunk_cnt = 1, bool safe_merging = true) {
     CompressingProcessor<Graph> compressor(g, chunk_cnt, safe_merging);
+    // Compressor only walks the graph structure, so the external indices can be updated in bulk
+    EventBatch<Graph> batch(g);
     return compressor.Run();
 }
+
+/**
+* Method compresses the vertices recorded by the tracker. Falls back to the full scan of
+* CompressAllVertices when more than full_scan_share of the graph vertices were touched.
+*/
+template<class Graph>
+size_t CompressDirtyVertices(Graph &g, DirtyVertexTracker<Graph> &tracker,
+                             size_t chunk_cnt = 1, bool safe_merging = true,
+                             double full_scan_share = 0.25) {
+    size_t compressed = 0;
+    if (double(tracker.size()) > full_scan_share * double(g.size())) {
+        compressed = CompressAllVertices(g, chunk_cnt, safe_merging);
+    } else {
+        CompressingProcessor<Graph> compressor(g, tracker, safe_merging);
+        EventBatch<Graph> batch(g);
+        compressed = compressor.Run();
+    }
+    // Vertices touched by the compression itself are not compressible
+    tracker.clear();
+    return compressed;
+}
 }
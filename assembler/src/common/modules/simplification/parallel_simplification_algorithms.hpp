@@ -62,7 +62,8 @@ public:
               length_bound_(length_bound),
               coverage_bound_(coverage_bound),
               handler_f_(handler_f) {
-
+        // The edges are deleted in parallel, so the events could not be batched
+        VERIFY(!g_.InEventBatch());
     }
 
     bool Process(VertexId v) {
@@ -324,6 +325,8 @@ public:
     }
 
     void PrepareForProcessing(size_t /*interesting_cnt*/) {
+        // Events are fired from the parallel processing, they could not be logged
+        VERIFY(!g_.InEventBatch());
     }
 
     //no conjugate copies here!
@@ -559,6 +562,8 @@ public:
     }
 
     void PrepareForProcessing(size_t interesting_cnt) {
+        // Merges are fired concurrently and could not be logged
+        VERIFY(!g_.InEventBatch());
         segment_storage_ = std::make_unique<restricted::IdSegmentStorage>(g_.GetGraphIdDistributor().Reserve(interesting_cnt * 2));
     }
 
@@ -0,0 +1,713 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "histogram.hpp"
+#include "histptr.hpp"
+#include "index_point.hpp"
+#include "utils/verify.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+namespace compact_hist {
+
+// Integral values in this range are stored as integers, their sums and differences are exact in float
+const float MAX_INT_VALUE = float(1 << 24);
+
+inline bool IsSmallInt(float f) {
+    return std::trunc(f) == f && std::abs(f) < MAX_INT_VALUE && !(f == 0 && std::signbit(f));
+}
+
+inline uint32_t FloatBits(float f) {
+    uint32_t res;
+    memcpy(&res, &f, sizeof(res));
+    return res;
+}
+
+inline float BitsFloat(uint32_t u) {
+    float res;
+    memcpy(&res, &u, sizeof(res));
+    return res;
+}
+
+inline void PutVarint(std::vector<uint8_t> &out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+inline uint64_t GetVarint(const uint8_t *&p) {
+    uint64_t res = 0;
+    unsigned shift = 0;
+    while (*p & 0x80) {
+        res |= uint64_t(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    res |= uint64_t(*p++) << shift;
+    return res;
+}
+
+inline void SkipVarint(const uint8_t *&p) {
+    while (*p++ & 0x80) {}
+}
+
+// Field is a varint with the lowest bit set when the rest is the float bit pattern
+inline void PutDistance(std::vector<uint8_t> &out, float d, float prev) {
+    if (IsSmallInt(d) && IsSmallInt(prev)) {
+        int64_t delta = int64_t(d) - int64_t(prev);
+        uint64_t zigzag = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+        PutVarint(out, zigzag << 1);
+    } else
+        PutVarint(out, (uint64_t(FloatBits(d)) << 1) | 1);
+}
+
+inline float GetDistance(const uint8_t *&p, float prev) {
+    uint64_t v = GetVarint(p);
+    if (v & 1)
+        return BitsFloat(uint32_t(v >> 1));
+    uint64_t zigzag = v >> 1;
+    int64_t delta = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+    return float(int64_t(prev) + delta);
+}
+
+inline void PutWeight(std::vector<uint8_t> &out, float w) {
+    if (IsSmallInt(w) && w >= 0)
+        PutVarint(out, uint64_t(w) << 1);
+    else
+        PutVarint(out, (uint64_t(FloatBits(w)) << 1) | 1);
+}
+
+inline float GetWeight(const uint8_t *&p) {
+    uint64_t v = GetVarint(p);
+    return (v & 1) ? BitsFloat(uint32_t(v >> 1)) : float(v >> 1);
+}
+
+}
+
+/**
+ * @brief  Memory-compact counterpart of Histogram for raw points. Points are sorted by distance
+ *         and stored as a byte stream where every point is a pair of LEB128 varints: the delta
+ *         from the previous distance and the weight. Integral values are stored as integers, the
+ *         others as their float bit pattern, so the storage is lossless.
+ *
+ *         The histogram is a single word, so it is kept in the index map directly. Streams of up
+ *         to 7 bytes are stored in the word itself, longer ones in a heap block together with a
+ *         directory of every 16th point, so a point is found without decoding the whole stream,
+ *         and a short sorted tail of uncompressed new points. The tail is merged into the stream
+ *         when it grows over 1/8 of it, so insertions are O(log n) amortized. Iterators merge the
+ *         stream and the tail and return points by value.
+ */
+template<class Point>
+class CompactHistogram {
+    typedef CompactHistogram<Point> self_type;
+
+    static_assert(std::is_trivially_copyable<Point>::value, "Tail points are moved as raw bytes");
+    static_assert(sizeof(void*) <= sizeof(uint64_t) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+                  "Inline stream is kept in the bytes of the word after the tag");
+
+    static const size_t INLINE_BYTES = 7;
+    static const size_t DIR_STEP = 16;
+    static const size_t MIN_TAIL = 4;
+    static const size_t MAX_TAIL = 1 << 15;
+
+    struct Header {
+        uint32_t size;          // points in the stream
+        uint32_t bytes;         // stream length
+        uint16_t tail;          // points in the tail
+        uint16_t tail_capacity;
+    };
+
+    // Distance and offset of the point in the stream
+    struct DirEntry {
+        float d;
+        uint32_t offset;
+    };
+
+public:
+    typedef Point key_type;
+    typedef Point value_type;
+    typedef size_t size_type;
+
+    class const_iterator : public boost::iterator_facade<const_iterator, const Point,
+                                                         boost::bidirectional_traversal_tag, Point> {
+    public:
+        const_iterator()
+                : hist_(nullptr), pos_(0), tail_(0), d_(0) {}
+
+    private:
+        friend class CompactHistogram;
+        friend class boost::iterator_core_access;
+
+        const_iterator(const CompactHistogram *hist, size_t pos, size_t tail, float d)
+                : hist_(hist), pos_(pos), tail_(tail), d_(d) {}
+
+        // Streams and tails never have points with the same distance
+        bool in_stream() const {
+            return pos_ < hist_->stream_bytes() &&
+                   (tail_ == hist_->tail_size() || !(hist_->tail()[tail_] < Point(d_, 0)));
+        }
+
+        Point dereference() const {
+            if (!in_stream())
+                return hist_->tail()[tail_];
+            const uint8_t *p = hist_->stream() + pos_;
+            compact_hist::SkipVarint(p);
+            return Point(d_, compact_hist::GetWeight(p));
+        }
+
+        void increment() {
+            if (!in_stream()) {
+                ++tail_;
+                return;
+            }
+            const uint8_t *data = hist_->stream(), *p = data + pos_;
+            compact_hist::SkipVarint(p);
+            compact_hist::SkipVarint(p);
+            pos_ = p - data;
+            if (pos_ < hist_->stream_bytes())
+                d_ = compact_hist::GetDistance(p, d_);
+        }
+
+        void decrement() {
+            if (pos_ == 0) {
+                --tail_;
+                return;
+            }
+
+            const uint8_t *data = hist_->stream();
+            // Varint ends with the only byte without the high bit, skip back the weight and the distance
+            size_t prev = pos_;
+            for (unsigned i = 0; i < 2; ++i) {
+                --prev;
+                while (prev > 0 && (data[prev - 1] & 0x80))
+                    --prev;
+            }
+
+            const uint8_t *p = data + pos_;
+            uint64_t v = (pos_ < hist_->stream_bytes() ? compact_hist::GetVarint(p) : 1);
+            float prev_d;
+            if (!(v & 1)) {
+                // The current distance is the delta from the previous one
+                uint64_t zigzag = v >> 1;
+                prev_d = float(int64_t(d_) - (int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1)));
+            } else
+                prev_d = hist_->DistanceAt(prev);
+
+            if (tail_ > 0 && Point(prev_d, 0) < hist_->tail()[tail_ - 1]) {
+                --tail_;
+                return;
+            }
+            pos_ = prev;
+            d_ = prev_d;
+        }
+
+        bool equal(const const_iterator &other) const {
+            return pos_ == other.pos_ && tail_ == other.tail_;
+        }
+
+        const CompactHistogram *hist_;
+        size_t pos_;
+        size_t tail_;
+        float d_;
+    };
+
+    typedef const_iterator iterator;
+
+    CompactHistogram() = default;
+
+    CompactHistogram(const self_type &x)
+            : word_(x.word_) {
+        if (const Header *h = x.header()) {
+            uint8_t *block = Allocate(BlockSize(h->bytes, h->size, h->tail_capacity));
+            memcpy(block, h, TailOffset(h->bytes, h->size) + h->tail * sizeof(Point));
+            word_ = reinterpret_cast<uint64_t>(block);
+        }
+    }
+
+    CompactHistogram(self_type &&x) noexcept
+            : word_(x.word_) {
+        x.word_ = 0;
+    }
+
+    template <class InputIterator>
+    CompactHistogram(InputIterator b, InputIterator e) {
+        // Same as inserting one by one into a set: the first of the equal points is kept
+        auto &points = Scratch(0);
+        points.assign(b, e);
+        std::stable_sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end(),
+                                 [](const Point &a, const Point &b) { return !(a < b) && !(b < a); }),
+                     points.end());
+        Encode(points);
+    }
+
+    CompactHistogram(std::initializer_list<Point> l)
+            : CompactHistogram(l.begin(), l.end()) {}
+
+    self_type &operator=(self_type x) {
+        swap(x);
+        return *this;
+    }
+
+    ~CompactHistogram() {
+        Free();
+    }
+
+    const_iterator begin() const {
+        const uint8_t *p = stream();
+        return const_iterator(this, 0, 0, stream_bytes() ? compact_hist::GetDistance(p, 0) : 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, stream_bytes(), tail_size(), 0);
+    }
+
+    size_type size() const {
+        if (is_inline())
+            return (word_ >> 1) & 0x7;
+        const Header *h = header();
+        return h ? h->size + h->tail : 0;
+    }
+
+    bool empty() const { return word_ == 0; }
+
+    size_type bytes_used() const {
+        const Header *h = header();
+        return sizeof(self_type) + (h ? BlockSize(h->bytes, h->size, h->tail_capacity) : 0);
+    }
+
+    void clear() {
+        Free();
+        word_ = 0;
+    }
+
+    void swap(self_type &x) {
+        std::swap(word_, x.word_);
+    }
+
+    // Merges the tail into the stream and releases the unused memory
+    void shrink_to_fit() {
+        const Header *h = header();
+        if (h && h->tail_capacity)
+            Encode(Decode(Scratch(0)));
+    }
+
+    size_type erase(const key_type &key) {
+        auto &points = Decode(Scratch(0));
+        auto it = std::lower_bound(points.begin(), points.end(), key);
+        if (it == points.end() || key < *it)
+            return 0;
+        points.erase(it);
+        Encode(points);
+        return 1;
+    }
+
+    template<class U>
+    size_t merge_point(const U &new_point) {
+        Point point(new_point);
+        if (Header *h = header()) {
+            if (uint8_t *weight = FindWeight(point)) {
+                if (AddWeight(weight, point))
+                    return 0;
+            } else {
+                Point *tail = this->tail(), *tail_end = tail + h->tail;
+                Point *it = std::lower_bound(tail, tail_end, point);
+                if (it != tail_end && !(point < *it)) {
+                    *it += point;
+                    return 0;
+                }
+                if (h->tail < TailLimit(h->size)) {
+                    InsertToTail(size_t(it - tail), point);
+                    return 1;
+                }
+            }
+        }
+
+        // Inline streams, full tails and weights changing their encoded length are re-encoded
+        auto &points = Decode(Scratch(0));
+        auto it = std::lower_bound(points.begin(), points.end(), point);
+        size_t added = 0;
+        if (it != points.end() && !(point < *it))
+            *it += point;
+        else {
+            points.insert(it, point);
+            added = 1;
+        }
+        Encode(points);
+        return added;
+    }
+
+    template<class OtherHist>
+    size_t merge(const OtherHist &other) {
+        size_t old_size = size();
+        auto &points = Decode(Scratch(0));
+        auto &to_add = Scratch(1);
+        to_add.assign(other.begin(), other.end());
+
+        auto &merged = Scratch(2);
+        merged.clear();
+        auto i = points.begin(), j = to_add.begin();
+        while (i != points.end() || j != to_add.end()) {
+            if (j == to_add.end() || (i != points.end() && *i < *j))
+                merged.push_back(*i++);
+            else if (i == points.end() || *j < *i)
+                merged.push_back(*j++);
+            else {
+                merged.push_back(*i++);
+                merged.back() += *j++;
+            }
+        }
+        Encode(merged);
+        return size() - old_size;
+    }
+
+    bool operator==(const self_type& x) const {
+        return size() == x.size() && std::equal(begin(), end(), x.begin());
+    }
+
+    bool operator!=(const self_type& other) const {
+        return !operator==(other);
+    }
+
+    template <typename Archive>
+    void BinArchiveSave(Archive &ar) const {
+        ar(size());
+        for (const auto &i : *this)
+            ar(i);
+    }
+
+    template <typename Archive>
+    void BinArchiveLoad(Archive &ar) {
+        VERIFY_MSG(!size(), "Cannot read into a non-empty histogram");
+        size_t count;
+        ar(count);
+        auto &points = Scratch(0);
+        points.resize(count);
+        for (auto &point : points)
+            ar(point);
+        VERIFY(std::is_sorted(points.begin(), points.end()));
+        Encode(points);
+    }
+
+private:
+    static size_t Align(size_t offset, size_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static size_t DirSize(size_t size) {
+        return size ? (size - 1) / DIR_STEP : 0;
+    }
+
+    static size_t DirOffset(size_t bytes) {
+        return Align(sizeof(Header) + bytes, alignof(DirEntry));
+    }
+
+    static size_t TailOffset(size_t bytes, size_t size) {
+        return Align(DirOffset(bytes) + DirSize(size) * sizeof(DirEntry), alignof(Point));
+    }
+
+    static size_t BlockSize(size_t bytes, size_t size, size_t tail_capacity) {
+        return TailOffset(bytes, size) + tail_capacity * sizeof(Point);
+    }
+
+    static size_t TailLimit(size_t size) {
+        size_t limit = size / 8;
+        return limit < MIN_TAIL ? MIN_TAIL : (limit > MAX_TAIL ? MAX_TAIL : limit);
+    }
+
+    static uint8_t *Allocate(size_t size) {
+        return static_cast<uint8_t*>(::operator new(size));
+    }
+
+    bool is_inline() const {
+        return word_ & 1;
+    }
+
+    Header *header() const {
+        return is_inline() ? nullptr : reinterpret_cast<Header*>(word_);
+    }
+
+    size_t stream_bytes() const {
+        if (is_inline())
+            return (word_ >> 4) & 0xF;
+        const Header *h = header();
+        return h ? h->bytes : 0;
+    }
+
+    const uint8_t *stream() const {
+        if (is_inline())
+            return reinterpret_cast<const uint8_t*>(&word_) + 1;
+        const Header *h = header();
+        return h ? reinterpret_cast<const uint8_t*>(h + 1) : nullptr;
+    }
+
+    const DirEntry *directory() const {
+        const Header *h = header();
+        return reinterpret_cast<const DirEntry*>(reinterpret_cast<const uint8_t*>(h) + DirOffset(h->bytes));
+    }
+
+    size_t tail_size() const {
+        const Header *h = header();
+        return h ? h->tail : 0;
+    }
+
+    Point *tail() const {
+        Header *h = header();
+        return reinterpret_cast<Point*>(reinterpret_cast<uint8_t*>(h) + TailOffset(h->bytes, h->size));
+    }
+
+    // Per-thread buffers for decoded points
+    static std::vector<Point> &Scratch(size_t i) {
+        static thread_local std::vector<Point> scratch[3];
+        return scratch[i];
+    }
+
+    std::vector<Point> &Decode(std::vector<Point> &points) const {
+        points.assign(begin(), end());
+        return points;
+    }
+
+    // Distance of the stream point starting at pos, decoded from the closest directory entry
+    float DistanceAt(size_t pos) const {
+        const uint8_t *data = stream(), *p = data;
+        size_t start = 0;
+        float d;
+        const DirEntry *dir = header() ? directory() : nullptr;
+        const DirEntry *it = dir ? std::upper_bound(dir, dir + DirSize(header()->size), pos,
+                                                    [](size_t pos, const DirEntry &e) { return pos < e.offset; })
+                                 : nullptr;
+        if (it != dir) {
+            --it;
+            start = it->offset;
+            p = data + start;
+            compact_hist::SkipVarint(p);
+            d = it->d;
+        } else
+            d = compact_hist::GetDistance(p, 0);
+
+        while (start < pos) {
+            compact_hist::SkipVarint(p);
+            start = p - data;
+            d = compact_hist::GetDistance(p, d);
+        }
+        return d;
+    }
+
+    // Weight of the stream point with the same distance, nullptr if there is no such point
+    uint8_t *FindWeight(const Point &point) const {
+        const Header *h = header();
+        uint8_t *data = const_cast<uint8_t*>(stream()), *end = data + h->bytes;
+        const DirEntry *dir = directory();
+        const DirEntry *it = std::upper_bound(dir, dir + DirSize(h->size), point,
+                                              [](const Point &point, const DirEntry &e) {
+                                                  return point < Point(e.d, 0);
+                                              });
+        const uint8_t *p = data;
+        float d;
+        if (it != dir) {
+            --it;
+            p = data + it->offset;
+            compact_hist::SkipVarint(p);
+            d = it->d;
+        } else
+            d = compact_hist::GetDistance(p, 0);
+
+        while (true) {
+            Point current(d, 0);
+            if (point < current)
+                return nullptr;
+            if (!(current < point))
+                return data + (p - data);
+            compact_hist::SkipVarint(p);
+            if (p == end)
+                return nullptr;
+            d = compact_hist::GetDistance(p, d);
+        }
+    }
+
+    // Adds the weight in place if it keeps the same encoded length
+    static bool AddWeight(uint8_t *weight, const Point &point) {
+        const uint8_t *p = weight;
+        Point current(point.d, compact_hist::GetWeight(p));
+        current += point;
+        auto &encoded = EncodeScratch();
+        encoded.clear();
+        compact_hist::PutWeight(encoded, current.weight);
+        if (encoded.size() != size_t(p - weight))
+            return false;
+        memcpy(weight, encoded.data(), encoded.size());
+        return true;
+    }
+
+    void InsertToTail(size_t idx, const Point &point) {
+        Header *h = header();
+        if (h->tail == h->tail_capacity)
+            Reallocate(h->tail_capacity ? std::min(TailLimit(h->size), 2 * size_t(h->tail_capacity))
+                                        : size_t(MIN_TAIL));
+        h = header();
+        Point *tail = this->tail();
+        memmove(tail + idx + 1, tail + idx, (h->tail - idx) * sizeof(Point));
+        memcpy(tail + idx, &point, sizeof(Point));
+        h->tail += 1;
+    }
+
+    void Reallocate(size_t tail_capacity) {
+        const Header *h = header();
+        uint8_t *block = Allocate(BlockSize(h->bytes, h->size, tail_capacity));
+        memcpy(block, h, TailOffset(h->bytes, h->size) + h->tail * sizeof(Point));
+        Free();
+        word_ = reinterpret_cast<uint64_t>(block);
+        header()->tail_capacity = uint16_t(tail_capacity);
+    }
+
+    static std::vector<uint8_t> &EncodeScratch() {
+        static thread_local std::vector<uint8_t> scratch;
+        return scratch;
+    }
+
+    static std::vector<DirEntry> &DirScratch() {
+        static thread_local std::vector<DirEntry> scratch;
+        return scratch;
+    }
+
+    void Encode(const std::vector<Point> &points) {
+        auto &encoded = EncodeScratch();
+        auto &dir = DirScratch();
+        encoded.clear();
+        dir.clear();
+        float prev = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const auto &point = points[i];
+            if (i && i % DIR_STEP == 0)
+                dir.push_back({ point.d, uint32_t(encoded.size()) });
+            compact_hist::PutDistance(encoded, point.d, prev);
+            compact_hist::PutWeight(encoded, point.weight);
+            prev = point.d;
+        }
+        VERIFY(encoded.size() <= std::numeric_limits<uint32_t>::max());
+
+        Free();
+        if (points.empty()) {
+            word_ = 0;
+        } else if (encoded.size() <= INLINE_BYTES) {
+            // Every point takes at least two bytes, so the size fits as well
+            word_ = 1 | (points.size() << 1) | (encoded.size() << 4);
+            memcpy(reinterpret_cast<uint8_t*>(&word_) + 1, encoded.data(), encoded.size());
+        } else {
+            size_t bytes = encoded.size();
+            uint8_t *block = Allocate(BlockSize(bytes, points.size(), 0));
+            Header *h = reinterpret_cast<Header*>(block);
+            h->size = uint32_t(points.size());
+            h->bytes = uint32_t(bytes);
+            h->tail = h->tail_capacity = 0;
+            memcpy(block + sizeof(Header), encoded.data(), bytes);
+            memcpy(block + DirOffset(bytes), dir.data(), dir.size() * sizeof(DirEntry));
+            word_ = reinterpret_cast<uint64_t>(block);
+        }
+    }
+
+    void Free() {
+        if (Header *h = header())
+            ::operator delete(h);
+    }
+
+    // Heap block, or the inline stream when the lowest bit is set: then the lowest byte keeps
+    // the tag, the number of points and the stream length, and the next bytes keep the stream
+    uint64_t word_ = 0;
+};
+
+template<typename T>
+inline std::ostream &operator<<(std::ostream &os, const CompactHistogram<T> &b) {
+    os << "{";
+    for (const auto& e : b)
+        os << e << "; ";
+    os << "}";
+    return os;
+}
+
+/**
+ * @brief Histogram type used by paired indices and buffers for the points of the given type.
+ *        Raw points of unclustered indices, which are the most numerous ones, are stored compactly.
+ */
+template<class Point>
+struct InnerHistogramType {
+    typedef Histogram<Point> type;
+};
+
+template<>
+struct InnerHistogramType<RawGapPoint> {
+    typedef CompactHistogram<RawGapPoint> type;
+};
+
+/**
+ * @brief How the histogram of an edge pair is kept in the index map. By default it is allocated
+ *        separately and the conjugate pair refers to it by a non-owning pointer.
+ */
+template<class Hist>
+struct HistSlot {
+    typedef StrongWeakPtr<Hist> type;
+    // Whatever is needed to make the slot of the conjugate pair
+    typedef Hist *view_type;
+
+    // Whether the slot of the conjugate pair can be read by itself
+    static const bool shared = true;
+
+    static type Owner() { return type(new Hist(), /* owning */ true); }
+    static view_type ViewOf(const type &owner) { return owner.get(); }
+    static type View(view_type hist) { return type(hist, /* owning */ false); }
+    static void Shrink(type &) {}
+};
+
+/**
+ * @brief Compact histograms are kept in the map itself. The conjugate pair keeps an empty one,
+ *        and the histogram is looked up by the canonical pair, which owns it.
+ */
+template<class Point>
+struct HistSlot<CompactHistogram<Point>> {
+    typedef CompactHistogram<Point> type;
+    typedef bool view_type;
+
+    static const bool shared = false;
+
+    static type Owner() { return type(); }
+    static view_type ViewOf(const type &) { return true; }
+    static type View(view_type) { return type(); }
+    static void Shrink(type &slot) { slot.shrink_to_fit(); }
+};
+
+template<class Hist>
+inline Hist &SlotHistogram(const StrongWeakPtr<Hist> &slot) {
+    return *slot;
+}
+
+template<class Point>
+inline CompactHistogram<Point> &SlotHistogram(CompactHistogram<Point> &slot) {
+    return slot;
+}
+
+template<class Point>
+inline const CompactHistogram<Point> &SlotHistogram(const CompactHistogram<Point> &slot) {
+    return slot;
+}
+
+}
+
+}
@@ -6,7 +6,7 @@
 
 #pragma once
 
-#include "histogram.hpp"
+#include "compact_histogram.hpp"
 #include "histptr.hpp"
 #include "paired_info.hpp"
 #include "paired_info_buffer.hpp"
@@ -28,8 +28,9 @@ class ConcurrentPairedBuffer : public PairedBufferBase<ConcurrentPairedBuffer<G,
 
   protected:
     using typename base::InnerPoint;
-    typedef omnigraph::de::Histogram<InnerPoint> InnerHistogram;
-    typedef omnigraph::de::StrongWeakPtr<InnerHistogram> InnerHistPtr;
+    typedef typename InnerHistogramType<InnerPoint>::type InnerHistogram;
+    typedef omnigraph::de::HistSlot<InnerHistogram> HistSlot;
+    typedef typename HistSlot::type InnerHistSlot;
 
 
   public:
@@ -38,7 +39,7 @@ class ConcurrentPairedBuffer : public PairedBufferBase<ConcurrentPairedBuffer<G,
     using typename base::EdgePair;
     using typename base::Point;
 
-    typedef Container<EdgeId, InnerHistPtr> InnerMap;
+    typedef Container<EdgeId, InnerHistSlot> InnerMap;
     typedef cuckoohash_map<EdgeId, InnerMap> StorageMap;
 
   public:
@@ -62,50 +63,50 @@ class ConcurrentPairedBuffer : public PairedBufferBase<ConcurrentPairedBuffer<G,
     }
 
   private:
-    std::pair<typename InnerHistPtr::pointer, size_t> InsertOne(EdgeId e1, EdgeId e2, InnerPoint p) {
+    std::pair<typename HistSlot::view_type, size_t> InsertOne(EdgeId e1, EdgeId e2, InnerPoint p) {
         if (!storage_.contains(e1))
             storage_.insert(e1, InnerMap()); // We can fail to insert here, it's ok
 
         size_t added = 0;
-        typename InnerHistPtr::pointer inserted = nullptr;
+        typename HistSlot::view_type inserted = {};
         storage_.update_fn(e1,
                            [&](InnerMap &second) { // Now we will hold lock to the whole "subtree" starting from e1
                                if (!second.count(e2)) {
-                                   inserted = new InnerHistogram();
-                                   second.insert(std::make_pair(e2, InnerHistPtr(inserted, /* owning */ true)));
+                                   auto res = second.insert(std::make_pair(e2, HistSlot::Owner()));
+                                   inserted = HistSlot::ViewOf(res.first->second);
                                }
-                               added = second[e2]->merge_point(p);
+                               added = SlotHistogram(second[e2]).merge_point(p);
                            });
 
         return { inserted, added };
     }
 
     template<class OtherHist>
-    std::pair<typename InnerHistPtr::pointer, size_t> InsertHist(EdgeId e1, EdgeId e2, const OtherHist &h) {
+    std::pair<typename HistSlot::view_type, size_t> InsertHist(EdgeId e1, EdgeId e2, const OtherHist &h) {
         if (!storage_.contains(e1))
             storage_.insert(e1, InnerMap()); // We can fail to insert here, it's ok
 
         size_t added = 0;
-        typename InnerHistPtr::pointer inserted = nullptr;
+        typename HistSlot::view_type inserted = {};
         storage_.update_fn(e1,
                            [&](InnerMap &second) { // Now we will hold lock to the whole "subtree" starting from e1
                                if (!second.count(e2)) {
-                                   inserted = new InnerHistogram();
-                                   second.insert(std::make_pair(e2, InnerHistPtr(inserted, /* owning */ true)));
+                                   auto res = second.insert(std::make_pair(e2, HistSlot::Owner()));
+                                   inserted = HistSlot::ViewOf(res.first->second);
                                }
-                               added = second[e2]->merge(h);
+                               added = SlotHistogram(second[e2]).merge(h);
                            });
 
         return { inserted, added };
     }
 
-    void InsertHistView(EdgeId e1, EdgeId e2, typename InnerHistPtr::pointer p) {
+    void InsertHistView(EdgeId e1, EdgeId e2, typename HistSlot::view_type view) {
         if (!storage_.contains(e1))
             storage_.insert(e1, InnerMap()); // We can fail to insert here, it's ok
 
         storage_.update_fn(e1,
                            [&](InnerMap &second) { // Now we will hold lock to the whole "subtree" starting from e1
-                               auto res = second.insert(std::make_pair(e2, InnerHistPtr(p, /* owning */ false)));
+                               auto res = second.insert(std::make_pair(e2, HistSlot::View(view)));
                                VERIFY_MSG(res.second, "Index insertion inconsistency");
                            });
     }
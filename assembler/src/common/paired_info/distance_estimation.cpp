@@ -88,10 +88,8 @@ void DistanceEstimator::Estimate(PairedInfoIndexT<Graph> &result, size_t nthread
         ProcessEdge(edge, index, buffer[omp_get_thread_num()]);
     }
 
-    for (size_t i = 0; i < nthreads; ++i) {
-        result.Merge(buffer[i]);
-        buffer[i].clear();
-    }
+    result.MergeAll(buffer, nthreads);
+    buffer.Clear();
 }
 
 DistanceEstimator::EstimHist DistanceEstimator::EstimateEdgePairDistances(EdgePair ep, const InHistogram &histogram,
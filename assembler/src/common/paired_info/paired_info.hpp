@@ -14,7 +14,10 @@
 #include <type_traits>
 #include <boost/iterator/iterator_facade.hpp>
 #include <btree/safe_btree_map.h>
+#include <algorithm>
 #include <set>
+#include <tuple>
+#include <vector>
 
 namespace omnigraph {
 
@@ -26,7 +29,8 @@ class PairedIndex : public PairedBuffer<G, Traits, Container> {
     typedef PairedBuffer<G, Traits, Container> base;
 
     typedef typename base::InnerHistogram InnerHistogram;
-    typedef typename base::InnerHistPtr InnerHistPtr;
+    typedef typename base::HistSlot HistSlot;
+    typedef typename base::InnerHistSlot InnerHistSlot;
     typedef typename base::InnerPoint InnerPoint;
 
     using typename base::EdgePair;
@@ -225,7 +229,7 @@ public:
             }
 
             EdgeHist dereference() const {
-                const auto& hist = *iter_->second;
+                const auto& hist = index_.HistOf(edge_, iter_->first, iter_->second);
                 return std::make_pair(iter_->first, HistProxy(hist, index_.CalcOffset(edge_)));
             }
 
@@ -292,12 +296,95 @@ public:
                 if (ep > conj)
                     continue;
 
-                base::Merge(ep.first, ep.second, *to_add.second);
+                base::Merge(ep.first, ep.second, SlotHistogram(to_add.second));
             }
         }
         VERIFY(this->size() >= index_to_add.size());
     }
 
+    /**
+     * @brief Adds the info from all the buffers, same as merging them one by one.
+     *        Edges are split into shards by id, all the buffers are merged into every
+     *        shard concurrently, then the conjugate views are inserted shard by shard.
+     */
+    template<class Buffers>
+    void MergeAll(Buffers& buffers, size_t nthreads = omp_get_max_threads()) {
+        typedef typename Buffers::value_type::InnerMap BufferMap;
+        typedef typename HistSlot::view_type HistView;
+        typedef std::pair<EdgeId, const BufferMap*> Source;
+
+        const size_t nshards = 4 * std::max<size_t>(nthreads, 1);
+        auto shard = [&](EdgeId e) { return size_t(this->graph_.int_id(e)) % nshards; };
+
+        // Per-shard sources in the buffer order, so the histograms are merged in the same order as by Merge()
+        std::vector<std::vector<Source>> sources(nshards);
+        std::vector<EdgeId> keys;
+        for (auto& buffer : buffers) {
+            auto locked_table = buffer.lock_table();
+            for (auto& kvpair : locked_table) {
+                sources[shard(kvpair.first)].emplace_back(kvpair.first, &kvpair.second);
+                keys.push_back(kvpair.first);
+            }
+        }
+
+        // Buffers are symmetric, so these are all the first edges of the resulting pairs. Outer map is
+        // only searched in the concurrent part below, so all of its entries are created in advance.
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (EdgeId e : keys)
+            this->storage_[e];
+
+        // Non-owning conjugates of new histograms, bucketed by (source shard, target shard)
+        std::vector<std::vector<std::tuple<EdgeId, EdgeId, HistView>>> views(nshards * nshards);
+        size_t added = 0;
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic) reduction(+ : added)
+        for (size_t s = 0; s < nshards; ++s) {
+            auto& shard_sources = sources[s];
+            std::stable_sort(shard_sources.begin(), shard_sources.end(),
+                             [](const Source& a, const Source& b) { return a.first < b.first; });
+            for (const auto& source : shard_sources) {
+                EdgeId e1 = source.first;
+                InnerMap& inner_map = this->storage_.find(e1)->second;
+                for (const auto& to_add : *source.second) {
+                    EdgeId e2 = to_add.first;
+                    EdgePair ep(e1, e2), conj = this->ConjugatePair(e1, e2);
+                    if (ep > conj)
+                        continue;
+
+                    bool selfconj = this->IsSelfConj(e1, e2);
+                    HistView inserted = {};
+                    auto it = inner_map.find(e2);
+                    if (it == inner_map.end()) {
+                        it = inner_map.insert(std::make_pair(e2, HistSlot::Owner())).first;
+                        inserted = HistSlot::ViewOf(it->second);
+                    }
+                    const auto& hist_to_add = SlotHistogram(to_add.second);
+                    size_t merged = SlotHistogram(it->second).merge(hist_to_add);
+                    added += selfconj ? merged : 2 * merged;
+                    if (selfconj) // This would double the weight of self-conjugate pairs
+                        SlotHistogram(it->second).merge(hist_to_add);
+                    else if (inserted)
+                        views[s * nshards + shard(conj.first)].emplace_back(conj.first, conj.second, inserted);
+                }
+            }
+            std::vector<Source>().swap(shard_sources);
+        }
+
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (size_t t = 0; t < nshards; ++t) {
+            for (size_t s = 0; s < nshards; ++s) {
+                for (const auto& view : views[s * nshards + t]) {
+                    auto res = this->storage_.find(std::get<0>(view))->second.insert(
+                            std::make_pair(std::get<1>(view), HistSlot::View(std::get<2>(view))));
+                    VERIFY_MSG(res.second, "Index insertion inconsistency");
+                }
+            }
+        }
+
+        this->size_ += added;
+        ShrinkHistograms(nthreads);
+    }
+
     template<class Buffer>
     typename std::enable_if<std::is_convertible<typename Buffer::InnerMap, InnerMap>::value,
         void>::type MoveAssign(Buffer& from) {
@@ -308,6 +395,7 @@ public:
             base_index[kvpair.first] = std::move(kvpair.second);
         }
         this->size_ = from.size();
+        ShrinkHistograms();
     }
 
 public:
@@ -362,7 +450,7 @@ public:
         if (i2 == map.end())
             return;
 
-        if (!i2->second->empty())
+        if (!HistOf(e1, e2, i2->second).empty())
             return;
 
         map.erase(e2);
@@ -380,7 +468,7 @@ public:
         if (i2 == map.end())
             return 0;
 
-        if (!i2->second->erase(point))
+        if (!SlotHistogram(i2->second).erase(point))
            return 0;
 
         return 1;
@@ -395,7 +483,7 @@ public:
         if (i2 == map.end())
             return 0;
 
-        size_t size_decrease = i2->second->size();
+        size_t size_decrease = HistOf(e1, e2, i2->second).size();
         map.erase(i2);
         if (map.empty()) //Prune empty maps
             this->storage_.erase(i1);
@@ -426,6 +514,29 @@ public:
     }
 
 private:
+    //Unshared histograms are stored in the canonical pair only, the conjugate one gets an empty slot
+    const InnerHistogram& HistOf(EdgeId e1, EdgeId e2, const InnerHistSlot& slot) const {
+        if (HistSlot::shared || this->IsCanonical(e1, e2))
+            return SlotHistogram(slot);
+        auto conj = this->ConjugatePair(e1, e2);
+        return GetImpl(conj.first, conj.second);
+    }
+
+    //Releases the spare capacity the histograms kept for insertions
+    void ShrinkHistograms(size_t nthreads = omp_get_max_threads()) {
+        if (HistSlot::shared)
+            return;
+        std::vector<InnerMap*> maps;
+        maps.reserve(this->storage_.size());
+        for (auto& kvpair : this->storage_)
+            maps.push_back(&kvpair.second);
+#       pragma omp parallel for num_threads(nthreads) schedule(guided)
+        for (size_t i = 0; i < maps.size(); ++i) {
+            for (auto& slot : *maps[i])
+                HistSlot::Shrink(slot.second);
+        }
+    }
+
     //When there is no such edge, returns a fake empty map for safety
     const InnerMap& GetImpl(EdgeId e) const {
         auto i = this->storage_.find(e);
@@ -440,7 +551,7 @@ private:
         if (i != this->storage_.end()) {
             auto j = i->second.find(e2);
             if (j != i->second.end())
-                return *j->second;
+                return HistOf(e1, e2, j->second);
         }
         return HistProxy::empty_hist();
     }
@@ -519,7 +630,7 @@ public:
             VERIFY_MSG(this->graph_.edges().find(iter->first) != this->graph_.edges().end(), " left edge wrong  " << iter->first);
             for (const auto &e_iter: iter->second) {
                 VERIFY_MSG(this->graph_.edges().find(e_iter.first) != this->graph_.edges().end(), " right edge wrong  " << e_iter.first);
-                sz += e_iter.second->size();
+                sz += HistOf(iter->first, e_iter.first, e_iter.second).size();
 
             }
         }
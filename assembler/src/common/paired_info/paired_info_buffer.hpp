@@ -6,7 +6,7 @@
 
 #pragma once
 
-#include "histogram.hpp"
+#include "compact_histogram.hpp"
 #include "histptr.hpp"
 
 #include "utils/logger/logger.hpp"
@@ -162,8 +162,9 @@ class PairedBuffer : public PairedBufferBase<PairedBuffer<G, Traits, Container>,
 
   protected:
     using typename base::InnerPoint;
-    typedef omnigraph::de::Histogram<InnerPoint> InnerHistogram;
-    typedef omnigraph::de::StrongWeakPtr<InnerHistogram> InnerHistPtr;
+    typedef typename InnerHistogramType<InnerPoint>::type InnerHistogram;
+    typedef omnigraph::de::HistSlot<InnerHistogram> HistSlot;
+    typedef typename HistSlot::type InnerHistSlot;
 
   public:
     using typename base::Graph;
@@ -171,7 +172,7 @@ class PairedBuffer : public PairedBufferBase<PairedBuffer<G, Traits, Container>,
     using typename base::EdgePair;
     using typename base::Point;
 
-    typedef Container<EdgeId, InnerHistPtr> InnerMap;
+    typedef Container<EdgeId, InnerHistSlot> InnerMap;
     typedef Container<EdgeId, InnerMap> StorageMap;
 
   public:
@@ -200,9 +201,9 @@ class PairedBuffer : public PairedBufferBase<PairedBuffer<G, Traits, Container>,
         for (const auto &i : storage_) {
             BinWrite(str, i.first.int_id());
             for (const auto &j : i.second) {
-                if (j.second.owning()) {
+                if (this->IsCanonical(i.first, j.first)) {
                     BinWrite(str, j.first.int_id());
-                    io::binary::BinWrite(str, *(j.second));
+                    io::binary::BinWrite(str, SlotHistogram(j.second));
                 }
             }
             BinWrite(str, (size_t)0); //null-term
@@ -219,51 +220,54 @@ class PairedBuffer : public PairedBufferBase<PairedBuffer<G, Traits, Container>,
                 auto e2 = BinRead<uint64_t>(str);
                 if (!e2) //null-term
                     break;
-                auto hist = new InnerHistogram();
-                io::binary::BinRead(str, *hist);
-                TRACE(e1 << "->" << e2 << ": " << hist->size() << "points");
-                storage_[e1][e2] = InnerHistPtr(hist, /* owning */ true);
+                auto &slot = storage_[e1][e2];
+                slot = HistSlot::Owner();
+                auto &hist = SlotHistogram(slot);
+                io::binary::BinRead(str, hist);
+                TRACE(e1 << "->" << e2 << ": " << hist.size() << "points");
                 bool selfconj = this->IsSelfConj(e1, e2);
-                size_t added = hist->size() * (selfconj ? 1 : 2);
+                size_t added = hist.size() * (selfconj ? 1 : 2);
                 this->size_ += added;
                 if (!selfconj) {
+                    // Map insertions might move the slot
+                    auto view = HistSlot::View(HistSlot::ViewOf(slot));
                     auto conj = this->ConjugatePair(e1, e2);
-                    storage_[conj.first][conj.second] = InnerHistPtr(hist, /* owning */ false);
+                    storage_[conj.first][conj.second] = std::move(view);
                 }
             }
         }
     }
 
   private:
-    std::pair<typename InnerHistPtr::pointer, size_t> InsertOne(EdgeId e1, EdgeId e2, InnerPoint p) {
+    std::pair<typename HistSlot::view_type, size_t> InsertOne(EdgeId e1, EdgeId e2, InnerPoint p) {
         InnerMap& second = storage_[e1];
-        typename InnerHistPtr::pointer inserted = nullptr;
+        typename HistSlot::view_type inserted = {};
         if (!second.count(e2)) {
-            inserted = new InnerHistogram();
-            second.insert(std::make_pair(e2, InnerHistPtr(inserted, /* owning */ true)));
+            auto res = second.insert(std::make_pair(e2, HistSlot::Owner()));
+            inserted = HistSlot::ViewOf(res.first->second);
         }
 
-        size_t added = second[e2]->merge_point(p);
+        size_t added = SlotHistogram(second[e2]).merge_point(p);
 
         return { inserted, added };
     }
 
     template<class OtherHist>
-    std::pair<typename InnerHistPtr::pointer, size_t> InsertHist(EdgeId e1, EdgeId e2, const OtherHist &h) {
+    std::pair<typename HistSlot::view_type, size_t> InsertHist(EdgeId e1, EdgeId e2, const OtherHist &h) {
         InnerMap& second = storage_[e1];
-        typename InnerHistPtr::pointer inserted = nullptr;
+        typename HistSlot::view_type inserted = {};
         if (!second.count(e2)) {
-            inserted = new InnerHistogram();
-            second.insert(std::make_pair(e2, InnerHistPtr(inserted, /* owning */ true)));
+            auto res = second.insert(std::make_pair(e2, HistSlot::Owner()));
+            inserted = HistSlot::ViewOf(res.first->second);
         }
 
-        size_t added = second[e2]->merge(h);
+        size_t added = SlotHistogram(second[e2]).merge(h);
 
         return { inserted, added };
     }
 
-    void InsertHistView(EdgeId e1, EdgeId e2, typename InnerHistPtr::pointer p) {
-        auto res = storage_[e1].insert(std::make_pair(e2, InnerHistPtr(p, /* owning */ false)));
+    void InsertHistView(EdgeId e1, EdgeId e2, typename HistSlot::view_type view) {
+        auto res = storage_[e1].insert(std::make_pair(e2, HistSlot::View(view)));
         VERIFY_MSG(res.second, "Index insertion inconsistency");
     }
 
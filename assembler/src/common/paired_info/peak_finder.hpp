@@ -16,12 +16,12 @@
 #define PEAKFINDER_HPP_
 
 #include "utils/verify.hpp"
+#include "math/fft.hpp"
 #include "data_divider.hpp"
 #include "paired_info.hpp"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <complex>
 #include <cmath>
 
 namespace  omnigraph{
@@ -31,7 +31,6 @@ namespace de {
 template <class EdgeId>
 class PeakFinder {
   typedef std::vector<std::pair<int, double>> PeakHist;
-  typedef std::complex<double> complex_t;
 
  public:
     PeakFinder(const std::vector<PairInfo<EdgeId>> &data,
@@ -73,17 +72,30 @@ class PeakFinder {
     }
     InitBaseline();
     SubtractBaseline();
-    FFTForward(hist_);
-    size_t Ncrit = (size_t) (cutoff);
-
-    //      cutting off - standard parabolic filter
-    for (size_t i = 0; i < data_len_ && i < Ncrit; ++i)
-      hist_[i] *= 1. - ((double) i * (double) i * 1.) / (double) (Ncrit * Ncrit);
 
-    for (size_t i = Ncrit; i < hist_.size(); ++i)
-      hist_[i] = 0.;
+    unsigned lg_n = 0;
+    while ((size_t(1) << lg_n) < data_len_)
+      ++lg_n;
+    auto &fft = math::RealFFT::ForThread(lg_n);
+    size_t n = fft.size();
+    hist_.resize(n, 0.);
+    fft.Forward(hist_.data());
+    size_t Ncrit = (size_t) (cutoff);
 
-    FFTBackward(hist_);
+    //      cutting off - standard parabolic filter, it is applied to the positive frequencies
+    //      only and then the real part is taken, so the symmetrized filter is used for the real spectrum
+    auto filter = [&](size_t i) {
+      if (i >= Ncrit)
+        return 0.;
+      if (i >= data_len_)
+        return 1.;
+      return 1. - ((double) i * (double) i * 1.) / (double) (Ncrit * Ncrit);
+    };
+    auto &spectrum = fft.spectrum();
+    for (size_t i = 0; i <= n / 2; ++i)
+      spectrum[i] *= .5 * (filter(i) + filter((n - i) % n));
+
+    fft.Inverse(hist_.data());
     AddBaseline();
   }
 
@@ -101,11 +113,11 @@ class PeakFinder {
     //size_t index_max = 0;
     //for (size_t i = 0; i < data_len_; ++i) {
     //TRACE(x_left_ + (int) i << " " << hist_[i]);
-    //if (hist_[i].real() > hist_[index_max].real())
+    //if (hist_[i] > hist_[index_max])
     //index_max = i;
     //}
     //vector<pair<int, double> > result;
-    //result.push_back(make_pair(x_left_ + index_max, hist_[index_max].real()));
+    //result.push_back(make_pair(x_left_ + index_max, hist_[index_max]));
     //return result;
     DEBUG("Listing peaks");
 
@@ -165,7 +177,7 @@ class PeakFinder {
         int left_bound = (x_left_ > (index - 20) ? x_left_ : (index - 20));
         int right_bound = (x_right_ < (index + 1 + 20) ? x_right_ : (index + 1 + 20));
         for (int i = left_bound; i < right_bound; ++i)
-          weight_ += hist_[i - x_left_].real();
+          weight_ += hist_[i - x_left_];
         TRACE("WEIGHT counted");
         std::pair<int, double> tmp_pair(index, 100. * weight_);
         if (!peaks_.count(index)) {
@@ -188,11 +200,11 @@ class PeakFinder {
     return peaks;
   }
 
-    const std::vector<complex_t> &getIn() const {
+    const std::vector<double> &getIn() const {
         return hist_;
     }
 
-    const std::vector<complex_t> &getOut() const {
+    const std::vector<double> &getOut() const {
         return hist_;
     }
 
@@ -206,61 +218,9 @@ private:
   std::vector<double> y_;
   size_t data_size_, data_len_;
   int x_left_, x_right_;
-  std::vector<complex_t> hist_;
-
-  size_t Rev(size_t num, size_t lg_n) {
-    size_t res = 0;
-    for (size_t i = 0; i < lg_n; ++i)
-      if (num & (1 << i))
-        res |= 1 << (lg_n - 1 - i);
-    return res;
-  }
-
-  void FFT(std::vector<complex_t> &vect, bool invert) {
-    size_t n = vect.size();
-    size_t lg_n = 0;
-    while ( (1u << lg_n) < n)
-      ++lg_n;
-
-    while (n < (1u << lg_n)) {
-      vect.push_back(0.);
-      ++n;
-    }
-
-    for (size_t i = 0; i < n; ++i)
-      if (i < Rev(i, lg_n))
-        swap(vect[i], vect[Rev(i, lg_n)]);
-
-    for (size_t len = 2; len < 1 + n; len <<= 1) {
-      double ang = 2 * M_PI / (double) len * (invert ? -1 : 1);
-      complex_t wlen(cos(ang), sin(ang));
-      for (size_t i = 0; i < n; i += len) {
-        complex_t w(1.);
-        for (size_t j = 0; j < (len >> 1); ++j) {
-          complex_t u = vect[i + j];
-          complex_t v = vect[i + j + (len >> 1)] * w;
-          vect[i + j] = u + v;
-          vect[i + j + (len >> 1)] = u - v;
-          w *= wlen;
-        }
-      }
-    }
-
-    if (invert)
-      for (size_t i = 0; i < n; ++i)
-        vect[i] /= (double) n;
-  }
-
-
-  void FFTForward(std::vector<complex_t>& vect) {
-    FFT(vect, false);
-  }
-
-  void FFTBackward(std::vector<complex_t>& vect) {
-    FFT(vect, true);
-  }
+  std::vector<double> hist_;
 
-  void ExtendLinear(std::vector<complex_t>& hist) {
+  void ExtendLinear(std::vector<double>& hist) {
     size_t ind = 0;
     weight_ = 0.;
     for (size_t i = 0; i < data_len_; ++i) {
@@ -273,7 +233,7 @@ private:
                         (double) (x_[ind + 1] - i - x_left_)) /
                         (double) (1 * (x_[ind + 1] - x_[ind])));
       }
-      weight_ += hist[i].real();     // filling the array on the fly
+      weight_ += hist[i];     // filling the array on the fly
 
       if (ind < data_size_ && ((int) i == x_[ind + 1] - x_left_))
         ++ind;
@@ -289,8 +249,8 @@ private:
     double mean_beg = 0.;
     double mean_end = 0.;
     for (size_t i = 0; i < Np; ++i) {
-      mean_beg += hist_[i].real();
-      mean_end += hist_[data_len_ - i - 1].real();
+      mean_beg += hist_[i];
+      mean_end += hist_[data_len_ - i - 1];
     }
     mean_beg /= 1. * (double) Np;
     mean_end /= 1. * (double) Np;
@@ -331,17 +291,17 @@ private:
 
   double LeftDerivative(int dist) const {
     VERIFY(dist > x_left_);
-    return hist_[dist - x_left_].real() - hist_[dist - x_left_ - 1].real();
+    return hist_[dist - x_left_] - hist_[dist - x_left_ - 1];
   }
 
   double RightDerivative(int dist) const {
     VERIFY(dist < x_right_ - 1);
-    return hist_[dist - x_left_ + 1].real() - hist_[dist - x_left_].real();
+    return hist_[dist - x_left_ + 1] - hist_[dist - x_left_];
   }
 
   double MiddleDerivative(int dist) const {
     VERIFY(dist > x_left_ && dist < x_right_ - 1);
-    return .5 * (hist_[dist - x_left_ + 1].real() - hist_[dist - x_left_ - 1].real());
+    return .5 * (hist_[dist - x_left_ + 1] - hist_[dist - x_left_ - 1]);
   }
 
   double Derivative(int dist) const {
@@ -360,7 +320,7 @@ private:
     int index_max = peak;
     TRACE("Looking for the maximum");
     for (int j = left_bound; j < right_bound; ++j)
-      if (math::ls(hist_[index_max - x_left_].real(), hist_[j - x_left_].real())) {
+      if (math::ls(hist_[index_max - x_left_], hist_[j - x_left_])) {
         index_max = j;
       }// else if (j < i && hist_[index_max - x_left_][0] == hist_[j - x_left][0] ) index_max = j;
     TRACE("Maximum is " << index_max);
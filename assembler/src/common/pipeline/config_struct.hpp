@@ -269,6 +269,7 @@ struct debruijn_config {
         };
 
         size_t cycle_iter_count;
+        size_t persistent_batch_size = 0;
 
         bool topology_simplif_enabled;
         tip_clipper tc;
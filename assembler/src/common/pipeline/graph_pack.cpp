@@ -12,6 +12,7 @@
 #include "assembly_graph/handlers/edges_position_handler.hpp"
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
 #include "common/modules/alignment/rna/ss_coverage.hpp"
+#include "io/binary/edge_index.hpp"
 #include "modules/alignment/edge_index.hpp"
 #include "modules/alignment/kmer_mapper.hpp"
 #include "modules/alignment/long_read_storage.hpp"
@@ -64,9 +65,18 @@ void GraphPack::EnsureIndex() {
     if (index.IsAttached())
         return;
 
+    io::binary::EdgeIndexIO<Graph> io;
+    if (!index_snapshot_.empty() && io.LoadSnapshot(index_snapshot_, index)) {
+        index.Attach();
+        return;
+    }
+
     INFO("Index refill");
     index.Refill();
     index.Attach();
+
+    if (!index_snapshot_.empty())
+        io.SaveSnapshot(index_snapshot_, index);
 }
 
 void GraphPack::EnsureBasicMapping() {
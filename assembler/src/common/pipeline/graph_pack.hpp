@@ -29,6 +29,12 @@ public:
     void FillQuality();
     void ClearQuality();
 
+    /**
+     * @brief  Makes EnsureIndex() reuse the edge index saved at basename if it was
+     *         built for the current graph, and save it there after a rebuild.
+     */
+    void SetIndexSnapshot(const std::string &basename) { index_snapshot_ = basename; }
+
     void EnsureIndex();
     void EnsureBasicMapping();
     void EnsureQuality();
@@ -47,6 +53,7 @@ public:
 private:
     size_t k_;
     std::string workdir_;
+    std::string index_snapshot_;
 };
 
 } // namespace debruijn_graph
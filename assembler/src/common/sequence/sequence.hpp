@@ -36,13 +36,44 @@ class Sequence {
                                     protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
         friend TrailingObjects;
 
-        ManagedNuclBuffer() {}
+        // External buffers keep the owner of the nucleotides in their place
+        struct ExternalRef {
+            std::shared_ptr<const void> owner;
+        };
+        static const size_t EXTERNAL_REF_SIZE = (sizeof(ExternalRef) + sizeof(ST) - 1) / sizeof(ST);
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        // Fits into the padding after the refcounter, so owned buffers are
+        // still the header followed by the nucleotides
+        bool external_;
+
+        ManagedNuclBuffer()
+                : external_(false) {}
+
+        ManagedNuclBuffer(size_t nucls, ST *buf)
+                : ManagedNuclBuffer() {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
+        explicit ManagedNuclBuffer(std::shared_ptr<const void> owner)
+                : external_(true) {
+            new (external_ref()) ExternalRef{std::move(owner)};
+        }
+
+        ExternalRef *external_ref() const {
+            return reinterpret_cast<ExternalRef*>(const_cast<ST*>(getTrailingObjects<ST>()));
+        }
+
       public:
+// GCC inlines this into the release of the zero-size default buffer and
+// flags the external branch that is never taken there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+        ~ManagedNuclBuffer() {
+            if (external_)
+                external_ref()->~ExternalRef();
+        }
+#pragma GCC diagnostic pop
+
         void operator delete(void *p) { ::operator delete(p); }
 
         static ManagedNuclBuffer *create(size_t nucls) {
@@ -55,14 +86,27 @@ class Sequence {
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
 
-        const ST *data() const { return getTrailingObjects<ST>(); }
-        ST *data() { return getTrailingObjects<ST>(); }
+        // External buffers only keep the nucleotides alive, the sequences
+        // referencing them point to the nucleotides directly
+        static ManagedNuclBuffer *create(std::shared_ptr<const void> owner) {
+            void *mem = ::operator new(totalSizeToAlloc<ST>(EXTERNAL_REF_SIZE));
+            return new (mem) ManagedNuclBuffer(std::move(owner));
+        }
+
+        // Nucleotides of an owned buffer
+        ST *data() {
+            VERIFY_DEV(!external_);
+            return getTrailingObjects<ST>();
+        }
     };
+    static_assert(sizeof(ManagedNuclBuffer) <= sizeof(ST), "Nucleotide buffer header grew");
 
     size_t size_ : 32;
     size_t from_ : 31;
     bool   rtl_  : 1;  // Right to left + complimentary (?)
     llvm::IntrusiveRefCntPtr<ManagedNuclBuffer> data_;
+    // Nucleotides of the buffer, either owned or external
+    const ST *bytes_;
 
     static size_t DataSize(size_t size) {
         return (size + STN - 1) >> STNBits;
@@ -125,13 +169,29 @@ class Sequence {
     inline bool WriteHeader(std::ostream &file) const;
 
     Sequence(size_t size, int)
-            : size_(size), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(size_)) {}
+            : Sequence(ManagedNuclBuffer::create(size), size) {}
 
     //Low level constructor. Handle with care.
     Sequence(const Sequence &seq, size_t from, size_t size, bool rtl)
-            : size_(size), from_(from), rtl_(rtl), data_(seq.data_) {}
+            : size_(size), from_(from), rtl_(rtl), data_(seq.data_), bytes_(seq.bytes_) {}
+
+    Sequence(ManagedNuclBuffer *buf, size_t size)
+            : size_(size), from_(0), rtl_(false), data_(buf), bytes_(buf->data()) {}
+
+    Sequence(ManagedNuclBuffer *buf, const ST *bytes, size_t size)
+            : size_(size), from_(0), rtl_(false), data_(buf), bytes_(bytes) {}
 
 public:
+    /**
+     * Sequence referencing nucleotides packed elsewhere (e.g. in a memory-mapped
+     * file) in the same layout as BinWrite() produces. No copy is made, the
+     * buffer should stay valid while owner is alive.
+     */
+    static Sequence FromExternal(const seq_element_type *data, size_t size,
+                                 std::shared_ptr<const void> owner) {
+        return Sequence(ManagedNuclBuffer::create(std::move(owner)), data, size);
+    }
+
     /**
      * Sequence initialization (arbitrary size string)
      *
@@ -181,19 +241,19 @@ public:
         size_ = rhs.size_;
         rtl_ = rhs.rtl_;
         data_ = rhs.data_;
+        bytes_ = rhs.bytes_;
 
         return *this;
     }
 
     char operator[](const size_t index) const {
         VERIFY_DEV(index < size_);
-        const ST *bytes = data_->data();
         if (rtl_) {
             size_t i = from_ + size_ - 1 - index;
-            return complement((bytes[i >> STNBits] >> ((i & (STN - 1)) << 1)) & 3);
+            return complement((bytes_[i >> STNBits] >> ((i & (STN - 1)) << 1)) & 3);
         } else {
             size_t i = from_ + index;
-            return (bytes[i >> STNBits] >> ((i & (STN - 1)) << 1)) & 3;
+            return (bytes_[i >> STNBits] >> ((i & (STN - 1)) << 1)) & 3;
         }
     }
 
@@ -201,7 +261,7 @@ public:
         if (size_ != that.size_)
             return false;
 
-        if (data_ == that.data_ && from_ == that.from_ && rtl_ == that.rtl_)
+        if (bytes_ == that.bytes_ && from_ == that.from_ && rtl_ == that.rtl_)
             return true;
 
         for (size_t i = 0; i < size_; ++i) {
@@ -384,7 +444,7 @@ std::string Sequence::str() const {
 
 std::string Sequence::err() const {
     std::ostringstream oss;
-    oss << "{ *data=" << data_->data() <<
+    oss << "{ *data=" << bytes_ <<
             ", from_=" << from_ <<
             ", size_=" << size_ <<
             ", rtl_=" << int(rtl_) << " }";
@@ -422,6 +482,7 @@ bool Sequence::BinRead(std::istream &file) {
     ReadHeader(file);
 
     data_ = llvm::IntrusiveRefCntPtr<ManagedNuclBuffer>(ManagedNuclBuffer::create(size_));
+    bytes_ = data_->data();
     file.read((char *) data_->data(), DataSize(size_) * sizeof(ST));
 
     return !file.fail();
@@ -436,7 +497,7 @@ bool Sequence::BinWrite(std::ostream &file) const {
 
     WriteHeader(file);
 
-    file.write((const char *) data_->data(), DataSize(size_) * sizeof(ST));
+    file.write((const char *) bytes_, DataSize(size_) * sizeof(ST));
 
     return !file.fail();
 }
@@ -20,6 +20,7 @@
 #include "io/reads/multifile_reader.hpp"
 
 #include "utils/filesystem/temporary.hpp"
+#include "utils/kmer_mph/kmer_counting_plan.hpp"
 #include "utils/ph_map/coverage_hash_map_builder.hpp"
 
 
@@ -40,6 +41,9 @@ struct ConstructionStorage {
     io::ReadStreamList<io::SingleReadSeq> read_streams;
     io::ReadStreamList<io::SingleReadSeq> contigs_streams;
     fs::TmpDir workdir;
+    // Total number of k+1-mers in the reads and the estimate of distinct ones (0 if unknown)
+    size_t kpomer_instances = 0;
+    size_t kpomers_estimate = 0;
 };
 
 bool add_trusted_contigs(io::DataSet<config::LibraryData> &libraries,
@@ -157,6 +161,10 @@ void Construction::init(debruijn_graph::GraphPack &gp, const char *) {
 
     dataset.aRL = double(total_nucls) / double(read_count);
     INFO("Average read length " << dataset.aRL);
+
+    size_t kplusone = gp.k() + 1;
+    storage().kpomer_instances = total_nucls > read_count * (kplusone - 1) ?
+                                 total_nucls - read_count * (kplusone - 1) : 0;
 }
 
 void Construction::fini(debruijn_graph::GraphPack &) {
@@ -189,6 +197,7 @@ class CoverageFilter: public Construction::Phase {
 
         INFO("Estimating k-mers cardinality");
         size_t kmers = EstimateCardinalityUpperBound(kplusone, read_streams, hasher, KmerFilter());
+        storage().kpomers_estimate = kmers;
 
         // Create main CQF using # of slots derived from estimated # of k-mers
         storage().cqf.reset(new qf::cqf(kmers));
@@ -227,7 +236,6 @@ public:
         auto &read_streams = storage().read_streams;
         auto &contigs_streams = storage().contigs_streams;
         const auto &index = storage().ext_index;
-        size_t buffer_size = storage().params.read_buffer_size;
         using storing_type = decltype(storage().ext_index)::storing_type;
 
         VERIFY_MSG(read_streams.size(), "No input streams specified");
@@ -239,10 +247,15 @@ public:
         using Splitter =  utils::DeBruijnReadKMerSplitter<io::SingleReadSeq,
                                                           utils::StoringTypeFilter<storing_type>>;
 
+        auto plan = kmers::KMerCountingPlan::Create(storage().kpomer_instances, storage().kpomers_estimate,
+                                                    RtSeq::GetDataSize(index.k() + 1) * sizeof(RtSeq::DataType),
+                                                    nthreads, storage().params.read_buffer_size);
+        plan.Log();
+
         kmers::KMerDiskCounter<RtSeq>
                 counter(storage().workdir,
-                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size));
-        auto kmers = counter.Count(10 * nthreads, nthreads);
+                        Splitter(storage().workdir, index.k() + 1, merge_streams, plan.buffer_size));
+        auto kmers = counter.Count(plan.num_buckets, plan.num_threads);
         storage().kmers.reset(new kmers::KMerDiskStorage<RtSeq>(std::move(kmers)));
     }
 
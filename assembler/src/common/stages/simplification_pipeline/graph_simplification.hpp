@@ -343,6 +343,16 @@ protected:
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    bool ProcessChecked(EdgeId e) override {
+        TRACE("Removing edge " << this->g().str(e));
+        edge_remover_.DeleteEdge(e);
+        return true;
+    }
+
 public:
     LowCoverageEdgeRemovingAlgorithm(Graph &g,
                                      const std::string &condition_str,
@@ -365,6 +375,7 @@ public:
                 std::make_shared<omnigraph::ParallelInterestingElementFinder<Graph>>(
                         AddAlternativesPresenceCondition(g, parser()),
                         simplif_info.chunk_cnt());
+        this->set_batch_size(simplif_info.batch_size());
     }
 
 private:
@@ -531,11 +542,13 @@ AlgoPtr<Graph> RelativeECRemoverInstance(Graph &g,
     if (!rcec_config.enabled)
         return nullptr;
 
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
             AddRelativeCoverageECCondition(g, rcec_config.rcec_ratio,
                                            AddAlternativesPresenceCondition(g, func::TypedPredicate<typename Graph::EdgeId>
                                                    (LengthUpperBound<Graph>(g, rcec_config.max_ec_length)))),
             info.chunk_cnt(), removal_handler, /*canonical_only*/true);
+    algo->set_batch_size(info.batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -556,13 +569,15 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
                                   const SimplifInfoContainer &info,
                                   EdgeRemovalHandlerF<Graph> removal_handler = nullptr,
                                   bool track_changes = true) {
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
                                                                         AddTipCondition(g, condition),
                                                                         info.chunk_cnt(),
                                                                         removal_handler,
                                                                         /*canonical_only*/true,
                                                                         LengthComparator<Graph>(g),
                                                                         track_changes);
+    algo->set_batch_size(info.batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -594,9 +609,11 @@ AlgoPtr<Graph> DeadEndInstance(Graph &g,
 
     ConditionParser<Graph> parser(g, dead_end_config.condition, info);
     auto condition = parser();
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
             AddDeadEndCondition(g, condition), info.chunk_cnt(), removal_handler, /*canonical_only*/true,
             LengthComparator<Graph>(g), /*track changes*/true);
+    algo->set_batch_size(info.batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -41,6 +41,7 @@ class SimplifInfoContainer {
     double detected_coverage_bound_;
     bool main_iteration_;
     size_t chunk_cnt_;
+    size_t batch_size_;
     debruijn_graph::config::pipeline_type mode_;
 
 public: 
@@ -51,6 +52,7 @@ public:
         detected_coverage_bound_(-1.0),
         main_iteration_(false),
         chunk_cnt_(-1ul),
+        batch_size_(0),
         mode_(mode) {
     }
 
@@ -78,6 +80,10 @@ public:
         return chunk_cnt_;
     }
 
+    size_t batch_size() const {
+        return batch_size_;
+    }
+
     debruijn_graph::config::pipeline_type mode() const {
         return mode_;
     }
@@ -106,6 +112,11 @@ public:
         chunk_cnt_ = chunk_cnt;
         return *this;
     }
+
+    SimplifInfoContainer& set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size;
+        return *this;
+    }
 };
 
 }
@@ -7,6 +7,7 @@
 #include "utils/logger/log_writers.hpp"
 #include "io/graph/gfa_reader.hpp"
 #include "io/binary/graph_pack.hpp"
+#include "io/binary/mapped_graph.hpp"
 
 #pragma once
 
@@ -28,6 +29,9 @@ static io::IdMapper<std::string> *LoadGraph(debruijn_graph::GraphPack &gp, const
         gfa::GFAReader gfa(filename);
         INFO("GFA segments: " << gfa.num_edges() << ", links: " << gfa.num_links());
         gfa.to_graph(graph, id_mapper);
+    } else if (utils::ends_with(filename, ".grmap")) {
+        CHECK_FATAL_ERROR(io::binary::MappedGraphIO<debruijn_graph::Graph>().LoadFile(filename, graph),
+                          "Cannot load mapped graph " << filename);
     } else {
         io::binary::BasePackIO().Load(filename, gp);
     }
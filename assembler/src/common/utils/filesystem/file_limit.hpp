@@ -19,6 +19,21 @@
 
 namespace utils {
 
+// Hard limit on the number of open files, i.e. the most limit_file() could set
+inline rlim_t get_file_limit() {
+  struct rlimit rl;
+
+  int res = getrlimit(RLIMIT_NOFILE, &rl);
+  CHECK_FATAL_ERROR(res == 0,
+             "getrlimit(2) call failed, errno = " << errno);
+
+#ifdef OPEN_MAX
+  return std::min<size_t>(rl.rlim_max, OPEN_MAX);
+#else
+  return rl.rlim_max;
+#endif
+}
+
 inline rlim_t limit_file(size_t limit) {
   struct rlimit rl;
 
@@ -0,0 +1,120 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/filesystem/file_limit.hpp"
+#include "utils/memory_limit.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <algorithm>
+
+namespace kmers {
+
+// Sizing of the disk-based k-mer counting derived from the expected amount of
+// k-mers and the available resources: number of bucket files, number of threads,
+// size of the per-thread splitting buffers and the resulting fan-in of per-bucket
+// merge (i.e. the number of sorted runs each bucket consists of).
+struct KMerCountingPlan {
+    unsigned num_buckets;
+    unsigned num_threads;
+    size_t buffer_size;
+    size_t merge_fan_in;
+
+    // kmer_instances: total number of k-mers in the input (with repetitions)
+    // distinct_kmers: estimated number of distinct k-mers (e.g. HLL estimate), 0 if unknown
+    // buffer_size: per-thread splitting buffer size in bytes, 0 to choose automatically
+    static KMerCountingPlan Create(size_t kmer_instances, size_t distinct_kmers,
+                                   size_t kmer_size, unsigned nthreads,
+                                   size_t buffer_size = 0,
+                                   size_t memory = utils::get_free_memory(),
+                                   size_t file_limit = utils::get_file_limit()) {
+        // Do not produce buckets smaller than this, many tiny files only add I/O overhead
+        const size_t kMinBucketBytes = 16ull << 20;
+        // Same as in KMerSortingSplitter::PrepareBuffers
+        const size_t kMaxBufferSize = 512ull << 20;
+        const size_t kMinCellSize = 16384;
+        // The buffer is allowed to grow beyond kMaxBufferSize to keep the merge fan-in below this
+        const size_t kMaxFanIn = 4096;
+        // Keep some descriptors for read streams, logs, etc.
+        const size_t kReservedFiles = 64;
+
+        KMerCountingPlan plan;
+        nthreads = std::max(nthreads, 1u);
+        if (!distinct_kmers || distinct_kmers > kmer_instances)
+            distinct_kmers = kmer_instances;
+        memory = std::max<size_t>(memory, 1);
+
+        // Splitting buffers of all threads get a third of the memory, as before. Each
+        // thread counts its own bucket, all of them (deduplicated runs, hence up to twice
+        // the number of distinct k-mers) should fit into a half of the memory.
+        size_t split_memory = memory / 3, count_memory = memory / 2;
+        size_t bucket_bytes = 2 * distinct_kmers * kmer_size;
+        auto by_memory = [&](size_t threads) {
+            return (size_t)((double)bucket_bytes * (double)threads / (double)count_memory + 1);
+        };
+        // The splitter never uses less than kMinCellSize k-mers per bucket
+        auto by_buffer = [&](size_t threads) {
+            return std::max<size_t>(split_memory / (threads * kMinCellSize * kmer_size), 1);
+        };
+
+        // More threads mean both more buffers and more buckets in memory at once
+        size_t threads = nthreads;
+        while (threads > 1 && std::max(by_memory(threads), threads) > by_buffer(threads))
+            threads -= 1;
+        if (threads < nthreads)
+            INFO("Using " << threads << " threads for k-mer counting to fit into the memory limit");
+
+        size_t by_size = std::max<size_t>(bucket_bytes / kMinBucketBytes, 1);
+        // The old fixed default is still fine unless it gives tiny buckets
+        size_t buckets = std::max(std::min<size_t>(10 * threads, by_size), by_memory(threads));
+        buckets = std::max<size_t>(buckets, threads);
+
+        // Both memory demands cannot be met, the buffers would be the first to overflow
+        if (buckets > by_buffer(threads)) {
+            buckets = by_buffer(threads);
+            WARN("Memory limit of " << memory / 1024 / 1024 << " Mb is too low for k-mer counting, "
+                 << "buckets of about " << bucket_bytes / buckets / 1024 / 1024 << " Mb each will be counted. "
+                 << "Consider increasing the memory limit");
+        }
+
+        // Never exceed the number of open files we can afford
+        size_t max_files = file_limit > 2 * threads + kReservedFiles ?
+                           file_limit - 2 * threads - kReservedFiles : threads;
+        if (buckets > max_files) {
+            WARN("Open file limit allows only " << max_files << " k-mer buckets instead of " << buckets);
+            buckets = std::max<size_t>(max_files, 1);
+        }
+
+        size_t min_buffer_size = kMinCellSize * buckets * kmer_size;
+        if (!buffer_size) {
+            buffer_size = std::min(kMaxBufferSize, split_memory / threads);
+            // Every buffer flush produces a sorted run in every bucket
+            size_t fan_in_buffer = kmer_instances * kmer_size / (threads * kMaxFanIn);
+            if (fan_in_buffer > buffer_size)
+                buffer_size = std::min(fan_in_buffer, split_memory / threads);
+        }
+        plan.buffer_size = std::max(buffer_size, min_buffer_size);
+        if (plan.buffer_size * threads > split_memory)
+            WARN("K-mer splitting buffers of " << plan.buffer_size * threads / 1024 / 1024
+                 << " Mb exceed the memory available for them (" << split_memory / 1024 / 1024 << " Mb)");
+
+        plan.num_buckets = (unsigned)buckets;
+        plan.num_threads = (unsigned)threads;
+        plan.merge_fan_in = std::max<size_t>(1, (kmer_instances * kmer_size + threads * plan.buffer_size - 1) /
+                                                (threads * plan.buffer_size));
+
+        return plan;
+    }
+
+    void Log() const {
+        INFO("K-mer counting plan: " << num_buckets << " buckets, " << num_threads << " threads, "
+             << (double)buffer_size / 1024.0 / 1024.0 << " Mb splitting buffer per thread, "
+             << "~" << merge_fan_in << " sorted runs per bucket");
+    }
+};
+
+}
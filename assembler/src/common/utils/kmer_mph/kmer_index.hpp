@@ -11,6 +11,7 @@
 
 #include <boomphf/BooPHF.h>
 
+#include <algorithm>
 #include <vector>
 #include <cmath>
 
@@ -89,6 +90,30 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Batched seq_idx(): res[i] = seq_idx(seqs[i]), overlapping the index cache
+  // misses of different k-mers
+  void seq_idx(const KMerSeq *seqs, size_t n, size_t *res) const {
+    const size_t batch = KMerDataIndex::LOOKUP_BATCH;
+    const KMerDataIndex *phfs[batch];
+    size_t buckets[batch];
+    for (size_t start = 0; start < n; start += batch) {
+      size_t cnt = std::min(batch, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        buckets[i] = seq_bucket(seqs[start + i]);
+        phfs[i] = &index_[buckets[i]];
+      }
+      KMerDataIndex::lookup(phfs, seqs + start, cnt, res + start);
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t &idx = res[start + i];
+        idx = (idx == -1ULL ? idx : segment_starts_[buckets[i]] + idx);
+      }
+    }
+  }
+
+  void prefetch(const KMerSeq &s) const {
+    index_[seq_bucket(s)].prefetch(s);
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
@@ -8,6 +8,7 @@
 #include "perfect_hash_map_builder.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include <cstdlib>
+#include <vector>
 
 namespace utils {
 
@@ -15,8 +16,10 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
     template<class ReadStream, class Index>
     void FillCoverageFromStream(ReadStream &stream, Index &index) const {
         typedef typename Index::KeyType Kmer;
+        typedef typename Index::KeyWithHash KeyWithHash;
         unsigned k = index.k();
 
+        std::vector<Kmer> kmers;
         while (!stream.eof()) {
             typename ReadStream::ReadT r;
             stream >> r;
@@ -25,15 +28,21 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
             if (seq.size() < k)
                 continue;
 
-            typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<Kmer>(k) >> 'A');
+            // Look up all the k-mers of the read at once to overlap the cache misses
+            kmers.clear();
+            Kmer kmer = seq.start<Kmer>(k) >> 'A';
             for (size_t j = k - 1; j < seq.size(); ++j) {
-                kwh <<= seq[j];
+                kmer <<= seq[j];
+                kmers.push_back(kmer);
+            }
+
+            index.ConstructKWHs(kmers.data(), kmers.size(), [&](size_t, const KeyWithHash &kwh) {
                 if (!kwh.is_minimal() || !index.valid(kwh))
-                    continue;
+                    return;
 
-#                   pragma omp atomic
+#               pragma omp atomic
                 index.get_raw_value_reference(kwh) += 1;
-            }
+            });
         }
     }
 
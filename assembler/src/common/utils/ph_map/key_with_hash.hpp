@@ -36,6 +36,10 @@ public:
     SimpleKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), ready_(false) {}
 
+    // Key with the already known index (e.g. from the batched lookup)
+    SimpleKeyWithHash(Key key, const HashFunction &hash, IdxType idx)
+            : hash_(hash), key_(key), idx_(idx), ready_(true) {}
+
     Key key() const {
         return key_;
     }
@@ -136,6 +140,10 @@ private:
     InvertableKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), is_minimal_(false), ready_(false) {}
 
+    // Key with the already known index of its canonical form (e.g. from the batched lookup)
+    InvertableKeyWithHash(Key key, const HashFunction &hash, IdxType idx)
+            : hash_(hash), key_(key), idx_(idx), is_minimal_(key.IsMinimal()), ready_(true) {}
+
     const Key &key() const {
         return key_;
     }
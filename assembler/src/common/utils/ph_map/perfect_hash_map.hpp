@@ -16,6 +16,8 @@
 #include "utils/kmer_mph/kmer_index.hpp"
 #include "utils/verify.hpp"
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cstdlib>
 #include <cstdint>
@@ -103,6 +105,34 @@ public:
         return KeyBase::valid(kwh.idx());
     }
 
+    /**
+     * @brief  Batched counterpart of ConstructKWH(): the keys are looked up in the
+     *         index all at once with their cache misses overlapped, then the values
+     *         of the keys are prefetched and f(i, kwh) is called for every key.
+     */
+    template<class F>
+    void ConstructKWHs(const KeyType *keys, size_t n, F f) const {
+        const size_t batch = 64;
+        std::array<KeyType, batch> canonical;
+        size_t idx[batch];
+        for (size_t start = 0; start < n; start += batch) {
+            size_t cnt = std::min(batch, n - start);
+            for (size_t i = 0; i < cnt; ++i)
+                canonical[i] = StoringType::canonical_key(keys[start + i]);
+            index_ptr_->seq_idx(canonical.data(), cnt, idx);
+            for (size_t i = 0; i < cnt; ++i)
+                if (KeyBase::valid(idx[i]))
+                    __builtin_prefetch(&data_[idx[i]]);
+            for (size_t i = 0; i < cnt; ++i)
+                f(start + i, KeyWithHash(keys[start + i], *index_ptr_, idx[i]));
+        }
+    }
+
+    // Starts loading the index data needed to look up the key, does not block
+    void prefetch(const KeyType &key) const {
+        index_ptr_->prefetch(StoringType::canonical_key(key));
+    }
+
     const V get_value(const KeyWithHash &kwh) const {
         return StoringType::get_value(data_, kwh);
     }
@@ -22,6 +22,11 @@ struct SimpleStoring {
         values[key.idx()] = value;
     }
 
+    template<class Key>
+    static const Key &canonical_key(const Key &key) {
+        return key;
+    }
+
     static constexpr bool IsInvertable() {
         return false;
     }
@@ -62,6 +67,11 @@ struct InvertableStoring {
         }
     }
 
+    template<class Key>
+    static Key canonical_key(const Key &key) {
+        return key.IsMinimal() ? key : !key;
+    }
+
     static constexpr bool IsInvertable() {
         return true;
     }
@@ -38,7 +38,8 @@ void ContigProcessor::ReadContig() {
 }
 
 void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm) {
-    unordered_map<size_t, position_description> all_positions;
+    PositionDescriptionMap &all_positions = read_positions_;
+    all_positions.clear();
     if (tmp.contig_id() < 0) {
         return;
     }
@@ -128,7 +129,7 @@ size_t ContigProcessor::UpdateOneBase(size_t i, stringstream &ss, const unordere
 }
 
 
-bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<size_t, position_description> &ps) const {
+bool ContigProcessor::CountPositions(const SingleSamRead &read, PositionDescriptionMap &ps) const {
 
     if (read.contig_id() < 0) {
         DEBUG("not this contig");
@@ -231,11 +232,11 @@ bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<si
 }
 
 
-bool ContigProcessor::CountPositions(const PairedSamRead &read, unordered_map<size_t, position_description> &ps) const {
+bool ContigProcessor::CountPositions(const PairedSamRead &read, PositionDescriptionMap &ps) const {
 
     TRACE("starting pairing");
     bool t1 = CountPositions(read.Left(), ps );
-    unordered_map<size_t, position_description> tmp;
+    PositionDescriptionMap tmp;
     bool t2 = CountPositions(read.Right(), tmp);
     //overlaps.. multimap? Look on qual?
     if (ps.size() == 0 || tmp.size() == 0) {
@@ -244,7 +245,7 @@ bool ContigProcessor::CountPositions(const PairedSamRead &read, unordered_map<si
         return false;
     }
     TRACE("counted, uniting maps of " << tmp.size() << " and " << ps.size());
-    ps.insert(tmp.begin(), tmp.end());
+    ps.insert(tmp);
     TRACE("united");
     return (t1 && t2);
 }
@@ -275,10 +276,11 @@ size_t ContigProcessor::ProcessMultipleSamFiles() {
                << " setting interesting positions heuristics to " << interesting_weight_cutoff);
     }
     ipp_.FillInterestingPositions(charts_);
+    PositionDescriptionMap &ps = read_positions_;
     for (const auto &sf : sam_files_) {
         MappedSamStream sm(sf.first);
         while (!sm.eof()) {
-            unordered_map<size_t, position_description> ps;
+            ps.clear();
             if (sf.second == io::LibraryType::PairedEnd ) {
                 PairedSamRead tmp;
                 sm >> tmp;
@@ -293,7 +295,7 @@ size_t ContigProcessor::ProcessMultipleSamFiles() {
         sm.close();
     }
     ipp_.UpdateInterestingPositions();
-    unordered_map<size_t, position_description> interesting_positions = ipp_.get_weights();
+    const auto &interesting_positions = ipp_.get_weights();
     stringstream s_new_contig;
     size_t total_changes = 0;
     for (size_t i = 0; i < contig_.length(); i++) {
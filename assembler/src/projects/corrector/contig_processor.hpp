@@ -32,6 +32,7 @@ class ContigProcessor {
     std::vector<position_description> charts_;
     InterestingPositionProcessor ipp_;
     std::vector<int> error_counts_;
+    PositionDescriptionMap read_positions_;
 
     const size_t kMaxErrorNum = 20;
     int interesting_weight_cutoff;
@@ -49,8 +50,8 @@ public:
 private:
     void ReadContig();
 //Moved from read.hpp
-    bool CountPositions(const SingleSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
-    bool CountPositions(const PairedSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
+    bool CountPositions(const SingleSamRead &read, PositionDescriptionMap &ps) const;
+    bool CountPositions(const PairedSamRead &read, PositionDescriptionMap &ps) const;
 
     void UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm);
     //returns: number of changed nucleotides;
@@ -67,6 +67,7 @@ void InterestingPositionProcessor::set_contig(const string &ctg) {
     size_t len = contig_.length();
     is_interesting_.resize(len);
     read_ids_.resize(len);
+    interesting_weights_.resize(len);
 }
 
 void InterestingPositionProcessor::UpdateInterestingPositions() {
@@ -89,11 +90,11 @@ void InterestingPositionProcessor::UpdateInterestingPositions() {
                             coef = wr_storage_[current_read_id].processed_positions * wr_storage_[current_read_id].processed_positions;
                         else if (strat == Strategy::AllExceptJustStarted)
                             coef = wr_storage_[current_read_id].is_first(current_pos, dir);
-                        interesting_weights[current_pos].votes[current_variant] += get_error_weight(
+                        interesting_weights_[current_pos].votes[current_variant] += get_error_weight(
                                 wr_storage_[current_read_id].error_num ) * coef;
                     }
                 }
-                size_t maxi = interesting_weights[current_pos].FoundOptimal(contig_[current_pos]);
+                size_t maxi = interesting_weights_[current_pos].FoundOptimal(contig_[current_pos]);
                 for (size_t i = 0; i < read_ids_[current_pos].size(); i++) {
                     size_t current_read_id = read_ids_[current_pos][i];
                     size_t current_variant = wr_storage_[current_read_id].positions[current_pos];
@@ -108,11 +109,11 @@ void InterestingPositionProcessor::UpdateInterestingPositions() {
                 if ((char) toupper(contig_[current_pos]) != pos_to_var[maxi]) {
                     DEBUG("Interesting positions differ at position " << current_pos);
                     DEBUG("Was " << (char) toupper(contig_[current_pos]) << "new " << pos_to_var[maxi]);
-                    DEBUG("weights" << interesting_weights[current_pos].str());
-                    changed_weights_[current_pos] = interesting_weights[current_pos];
+                    DEBUG("weights" << interesting_weights_[current_pos].str());
+                    changed_weights_[current_pos] = interesting_weights_[current_pos];
                 }
                 //for backward pass
-                interesting_weights[current_pos].clear();
+                interesting_weights_[current_pos].clear();
             }
         }
         if (dir == 1)
@@ -22,7 +22,7 @@ class InterestingPositionProcessor {
     std::vector<bool> is_interesting_;
     std::vector<std::vector<size_t> > read_ids_;
     WeightedReadStorage wr_storage_;
-    std::unordered_map<size_t, position_description> interesting_weights;
+    std::vector<position_description> interesting_weights_;
     std::unordered_map<size_t, position_description> changed_weights_;
 
 //I wonder if anywhere else in spades google style guide convention on consts names is kept
@@ -47,7 +47,7 @@ public:
         return is_interesting_[position];
     }
 
-    std::unordered_map<size_t, position_description> get_weights() const {
+    const std::unordered_map<size_t, position_description> &get_weights() const {
         return changed_weights_;
     }
     void UpdateInterestingRead(const PositionDescriptionMap &ps);
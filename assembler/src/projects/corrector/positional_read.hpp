@@ -14,6 +14,7 @@
 #include <vector>
 #include <limits>
 #include <algorithm>
+#include <utility>
 
 namespace corrector {
 
@@ -51,7 +52,77 @@ struct position_description {
     std::string str() const;
     void clear() ;
 };
-typedef std::unordered_map <size_t, position_description> PositionDescriptionMap;
+
+// Per-read pileup: contig positions touched by a single (or paired) read
+// together with their descriptions. Reads touch positions in (almost)
+// increasing order, so the storage is a flat vector sorted by position
+// rather than a hash map.
+class PositionDescriptionMap {
+public:
+    typedef std::pair<size_t, position_description> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    position_description &operator[](size_t pos) {
+        if (!data_.empty() && data_.back().first == pos)
+            return data_.back().second;
+        if (data_.empty() || data_.back().first < pos) {
+            data_.emplace_back(pos, position_description());
+            return data_.back().second;
+        }
+
+        auto it = lower_bound(pos);
+        if (it == data_.end() || it->first != pos)
+            it = data_.emplace(it, pos, position_description());
+        return it->second;
+    }
+
+    const_iterator find(size_t pos) const {
+        auto it = lower_bound(pos);
+        return (it != data_.end() && it->first == pos) ? it : data_.end();
+    }
+
+    // Adds positions of another pileup which are not present here yet,
+    // existing descriptions are kept intact
+    void insert(const PositionDescriptionMap &other) {
+        if (other.empty())
+            return;
+        std::vector<value_type> merged;
+        merged.reserve(data_.size() + other.size());
+        auto it = data_.begin();
+        auto oit = other.begin();
+        while (it != data_.end() || oit != other.end()) {
+            if (oit == other.end() || (it != data_.end() && it->first <= oit->first)) {
+                if (oit != other.end() && it->first == oit->first)
+                    ++oit;
+                merged.push_back(std::move(*it++));
+            } else {
+                merged.push_back(*oit++);
+            }
+        }
+        data_.swap(merged);
+    }
+
+    const_iterator begin() const { return data_.begin(); }
+    const_iterator end() const { return data_.end(); }
+    iterator begin() { return data_.begin(); }
+    iterator end() { return data_.end(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+    void clear() { data_.clear(); }
+
+private:
+    const_iterator lower_bound(size_t pos) const {
+        return std::lower_bound(data_.begin(), data_.end(), pos,
+                                [](const value_type &v, size_t p) { return v.first < p; });
+    }
+    iterator lower_bound(size_t pos) {
+        return std::lower_bound(data_.begin(), data_.end(), pos,
+                                [](const value_type &v, size_t p) { return v.first < p; });
+    }
+
+    std::vector<value_type> data_;
+};
 
 struct WeightedPositionalRead {
     std::unordered_map<size_t, size_t> positions;
@@ -66,8 +137,8 @@ struct WeightedPositionalRead {
         last_pos = 0;
         non_interesting_error_num = 0;
         for (size_t i = 0; i < int_pos.size(); i++ ) {
+            auto tmp = ps.find(int_pos[i]);
             for (size_t j = 0; j < MAX_VARIANTS; j++) {
-                PositionDescriptionMap::const_iterator tmp = ps.find(int_pos[i]);
                 first_pos = std::min(first_pos, int_pos[i]);
                 last_pos = std::max(last_pos, int_pos[i]);
                 if (tmp != ps.end()) {
@@ -22,6 +22,7 @@
 #include "io/dataset_support/dataset_readers.hpp"
 #include "io/reads/osequencestream.hpp"
 #include "io/binary/basic.hpp"
+#include "io/binary/mapped_graph.hpp"
 
 #include "version.hpp"
 
@@ -48,7 +49,7 @@ struct gcfg {
     gcfg()
         : k(21), tmpdir("tmp"), outfile("-"),
           nthreads(omp_get_max_threads() / 2 + 1), buff_size(512ULL << 20),
-          mode(output_type::unitigs), coverage(false)
+          mode(output_type::unitigs), coverage(false), save_grmap(false)
     {}
 
     unsigned k;
@@ -59,6 +60,7 @@ struct gcfg {
     size_t buff_size;
     enum output_type mode;
     bool coverage;
+    bool save_grmap;
 };
 
 
@@ -73,6 +75,7 @@ void process_cmdline(int argc, char **argv, gcfg &cfg) {
       (option("-t") & integer("value", cfg.nthreads)) % "# of threads to use",
       (option("-tmp-dir") & value("dir", cfg.tmpdir)) % "scratch directory to use",
       (option("-b") & integer("value", cfg.buff_size)) % "sorting buffer size, per thread",
+      (option("--grmap").set(cfg.save_grmap)) % "also save the graph in memory-mapped format to <output filename>.grmap",
       one_of(option("--unitigs").set(cfg.mode, output_type::unitigs) % "produce unitigs (default)",
              option("--fastg").set(cfg.mode, output_type::fastg) % "produce graph in FASTG format",
              option("--gfa").set(cfg.mode, output_type::gfa) % "produce graph in GFA1 format",
@@ -187,7 +190,7 @@ int main(int argc, char* argv[]) {
             size_t idx = 1;
             std::ofstream f(cfg.outfile);
             for (const auto &edge: edge_sequences) {
-                f << std::string(">") << io::MakeContigId(idx++, edge.size(), "EDGE") << std::endl;
+                f << std::string(">") << io::MakeContigId(idx++, edge.size(), "EDGE") << '\n';
                 io::WriteWrapped(edge.str(), f);
             }
         } else {
@@ -212,7 +215,7 @@ int main(int argc, char* argv[]) {
 
             INFO("Saving graph to " << cfg.outfile);
             if (cfg.mode == output_type::gfa) {
-                std::ofstream f(cfg.outfile);
+                io::buffered_ofstream f(cfg.outfile);
                 gfa::GFAWriter gfa_writer(g, f);
                 gfa_writer.WriteSegmentsAndLinks();
             } else if (cfg.mode == output_type::fastg) {
@@ -222,6 +225,11 @@ int main(int argc, char* argv[]) {
                 io::binary::BasicGraphIO<debruijn_graph::DeBruijnGraph>().Save(cfg.outfile, g);
             } else
                 FATAL_ERROR("Invalid mode");
+
+            if (cfg.save_grmap) {
+                INFO("Saving memory-mapped graph to " << cfg.outfile << ".grmap");
+                io::binary::MappedGraphIO<debruijn_graph::DeBruijnGraph>().Save(cfg.outfile, g);
+            }
         }
     } catch (const std::string &s) {
         std::cerr << s << std::endl;
@@ -14,6 +14,8 @@
 #include "io/dataset_support/read_converter.hpp"
 #include "io/dataset_support/dataset_readers.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/mapped_graph.hpp"
+#include "io/utils/buffered_ofstream.hpp"
 
 #include "assembly_graph/paths/bidirectional_path_io/bidirectional_path_output.hpp"
 
@@ -148,6 +150,9 @@ void LoadGraph(debruijn_graph::ConjugateDeBruijnGraph &graph, const std::string
         gfa::GFAReader gfa(filename);
         INFO("GFA segments: " << gfa.num_edges() << ", links: " << gfa.num_links());
         gfa.to_graph(graph, id_mapper);
+    } else if (utils::ends_with(filename, ".grmap")) {
+        CHECK_FATAL_ERROR(io::binary::MappedGraphIO<debruijn_graph::ConjugateDeBruijnGraph>().LoadFile(filename, graph),
+                          "Cannot load mapped graph " << filename);
     } else {
         io::binary::Load(filename, graph);
     }
@@ -197,6 +202,7 @@ int main(int argc, char* argv[]) {
         debruijn_graph::config::init_libs(dataset, nthreads, tmpdir + "/");
 
         gp.get_mutable<KmerMapper<Graph>>().Attach();
+        gp.SetIndexSnapshot(fs::append_path(tmpdir, fs::filename(cfg.graph)));
         gp.EnsureBasicMapping();
 
         for (size_t i = 0; i < dataset.lib_count(); ++i) {
@@ -219,7 +225,7 @@ int main(int argc, char* argv[]) {
             }
             INFO("Saving to " << cfg.outfile);
 
-            std::ofstream os(cfg.outfile);
+            io::buffered_ofstream os(cfg.outfile);
             //FIXME fix behavior when we don't have the mapper
             path_extend::GFAPathWriter gfa_writer(graph, os,
                                                   io::MapNamingF<debruijn_graph::ConjugateDeBruijnGraph>(*id_mapper));
@@ -9,6 +9,7 @@
 #include "position_storage.hpp"
 #include "projects/unitig_coverage/profile_storage.hpp"
 #include "io/graph/gfa_writer.hpp"
+#include "io/utils/buffered_ofstream.hpp"
 #include "toolchain/utils.hpp"
 
 #include "utils/segfault_handler.hpp"
@@ -24,7 +25,7 @@ using namespace debruijn_graph;
 
 struct gcfg {
     gcfg() : k(0), RL(0),
-             save_gfa(false), save_gp(false),
+             save_gfa(false), save_gp(false), save_grmap(false),
              use_cov_ratios(false),
              nthreads(omp_get_max_threads() / 2 + 1) {}
 
@@ -39,6 +40,7 @@ struct gcfg {
     std::string outfile;
     bool save_gfa;
     bool save_gp;
+    bool save_grmap;
     bool use_cov_ratios;
     unsigned nthreads;
 };
@@ -53,6 +55,7 @@ static void process_cmdline(int argc, char **argv, gcfg &cfg) {
       option("--spades-gp").set(cfg.save_gp) % "produce output graph pack in SPAdes internal format (default: false). "
                                                       "Recommended if bulges are removed to improve further read mapping. "
                                                       "In case GFA output is required with graph pack specify '--gfa'",
+      option("--grmap").set(cfg.save_grmap) % "produce graph in memory-mapped format (default: false)",
       option("--use-cov-ratios").set(cfg.use_cov_ratios) % "enable procedures based on unitig coverage ratios (default: false)",
       (required("-k") & integer("value", cfg.k)) % "k-mer length to use",
       (required("--read-length") & integer("value", cfg.RL)) % "read length",
@@ -252,9 +255,14 @@ int main(int argc, char** argv) {
             io::binary::BasePackIO().Save(cfg.outfile, gp);
         }
 
+        if (cfg.save_grmap) {
+            INFO("Saving memory-mapped graph");
+            io::binary::MappedGraphIO<debruijn_graph::Graph>().Save(cfg.outfile, graph);
+        }
+
         if (cfg.save_gfa || !cfg.save_gp) {
             INFO("Saving GFA");
-            std::ofstream os(cfg.outfile + ".gfa");
+            io::buffered_ofstream os(cfg.outfile + ".gfa");
             gfa::GFAWriter writer(graph, os);
             writer.WriteSegmentsAndLinks();
         }
@@ -14,6 +14,7 @@
 
 #include "io/reads/ireadstream.hpp"
 #include "io/kmers/mmapped_writer.hpp"
+#include "io/utils/buffered_ofstream.hpp"
 #include "utils/filesystem/path_helper.hpp"
 
 #include <iostream>
@@ -208,8 +209,8 @@ std::string CorrectSingleReadSet(size_t ilib, size_t iread, const std::string &f
                         std::to_string(iread) + ".cor.fastq";
 
   std::string outcor = getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, usuffix);
-  std::ofstream ofgood(outcor.c_str());
-  std::ofstream ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq").c_str(),
+  io::buffered_ofstream ofgood(outcor.c_str());
+  io::buffered_ofstream ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq").c_str(),
                       std::ios::out | std::ios::ate);
   stats += CorrectReadFile(*Globals::kmer_data, fn, &ofgood, &ofbad);
   return outcor;
@@ -242,13 +243,13 @@ size_t CorrectAllReads() {
       std::string outcorr = getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, usuffix);
       std::string outcoru = getReadsFilename(cfg::get().output_dir, unpaired,  Globals::iteration_no, usuffix);
 
-      std::ofstream ofcorl(outcorl.c_str());
-      std::ofstream ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq").c_str(),
+      io::buffered_ofstream ofcorl(outcorl.c_str());
+      io::buffered_ofstream ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq").c_str(),
                            std::ios::out | std::ios::ate);
-      std::ofstream ofcorr(outcorr.c_str());
-      std::ofstream ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq").c_str(),
+      io::buffered_ofstream ofcorr(outcorr.c_str());
+      io::buffered_ofstream ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq").c_str(),
                            std::ios::out | std::ios::ate);
-      std::ofstream ofunp (outcoru.c_str());
+      io::buffered_ofstream ofunp (outcoru.c_str());
 
       stats += CorrectPairedReadFiles(*Globals::kmer_data,
                              I->first, I->second,
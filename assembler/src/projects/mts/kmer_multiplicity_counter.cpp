@@ -12,6 +12,7 @@
 #include "kmc_api/kmc_file.h"
 //#include "omp.h"
 #include "io/kmers/mmapped_reader.hpp"
+#include "adt/loser_tree.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/stl_utils.hpp"
 #include "utils/ph_map/perfect_hash_map_builder.hpp"
@@ -29,6 +30,31 @@ class KmerMultiplicityCounter {
     size_t k_ ;
     std::string file_prefix_;
 
+    // Provides 0123 symbols of KMC k-mer, so RtSeq could be packed directly
+    struct KmcKmerSymbols {
+        CKmerAPI &kmer;
+        size_t k;
+
+        char operator[](size_t i) const {
+            return (char) kmer.get_num_symbol((unsigned) i);
+        }
+
+        size_t size() const {
+            return k;
+        }
+    };
+
+    // Compares only k-mer part of (k-mer, count) records
+    struct KmerRecordLess {
+        size_t rawcnt;
+
+        template<class A, class B>
+        bool operator()(const A &lhs, const B &rhs) const {
+            return std::lexicographical_compare(lhs.data(), lhs.data() + rawcnt,
+                                                rhs.data(), rhs.data() + rawcnt);
+        }
+    };
+
     //TODO: get rid of intermediate .bin file
     string ParseKmc(const string& filename) {
         CKMCFile kmcFile;
@@ -38,7 +64,7 @@ class KmerMultiplicityCounter {
         std::string parsed_filename = filename + KMER_PARSED_EXTENSION;
         std::ofstream output(parsed_filename, std::ios::binary);
         while (kmcFile.ReadNextKmer(kmer, count)) {
-            RtSeq seq(k_, kmer.to_string());
+            RtSeq seq(k_, KmcKmerSymbols{kmer, k_});
             seq.BinWrite(output);
             seq_element_type tmp = count;
             output.write((char*) &(tmp), sizeof(seq_element_type));
@@ -58,33 +84,24 @@ class KmerMultiplicityCounter {
         return sorted_filename;
     }
 
-    bool ReadKmerWithCount(std::ifstream& infile, std::pair<RtSeq, uint32>& res) {
-        RtSeq seq(res.first.size());
-        if (!seq.BinRead(infile)) {
-            return false;
-        }
-        seq_element_type tmp;
-        infile.read((char*) &tmp, sizeof(seq_element_type));
-        res = {seq, (uint32) tmp};
-        return true;
-    }
-
     fs::TmpFile FilterCombinedKmers(fs::TmpDir workdir, const std::vector<string>& files,
-                                    size_t all_min, size_t min_mult) {
+                                    size_t all_min, size_t min_mult, size_t nthreads) {
         size_t n = files.size();
-        vector<std::unique_ptr<ifstream>> infiles;
-        infiles.reserve(n);
-        for (auto fn : files) {
-            INFO("Processing " << fn);
-            auto parsed = ParseKmc(fn);
-            auto sorted = SortKmersCountFile(parsed);
-            infiles.emplace_back(new std::ifstream(sorted));
+        std::vector<string> sorted(n);
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (size_t i = 0; i < n; ++i) {
+            INFO("Processing " << files[i]);
+            sorted[i] = SortKmersCountFile(ParseKmc(files[i]));
         }
-        vector<std::pair<RtSeq, uint32>> top_kmer(n, {RtSeq(k_), 0});
-        vector<bool> alive(n, false);
 
-        for (size_t i = 0; i < n; i++) {
-            alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
+        size_t rawcnt = RtSeq::GetDataSize(k_);
+        typedef MMappedRecordArrayReader<seq_element_type> RecordReader;
+        std::vector<std::unique_ptr<RecordReader>> inputs;
+        std::vector<adt::iterator_range<RecordReader::iterator>> runs;
+        inputs.reserve(n);
+        for (const auto &fn : sorted) {
+            inputs.emplace_back(new RecordReader(fn, rawcnt + 1, /* unlink */ true));
+            runs.push_back(adt::make_range(inputs.back()->begin(), inputs.back()->end()));
         }
 
         auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
@@ -93,46 +110,26 @@ class KmerMultiplicityCounter {
         std::ofstream output_kmer(*kmer_file, std::ios::binary);
         std::ofstream mpl_file(file_prefix_ + ".bpr", std::ios_base::binary);
 
-        RtSeq::less3 kmer_less;
-        while (true) {
-            boost::optional<RtSeq> min_kmer;
-            size_t cnt_min = 0, num_samples = 0;
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i]) {
-                    RtSeq& cur_kmer = top_kmer[i].first;
-                    if (!min_kmer || kmer_less(cur_kmer, *min_kmer)) {
-                        min_kmer = cur_kmer;
-                        cnt_min = 0;
-                    }
-                    if (cur_kmer == *min_kmer) {
-                        ++cnt_min;
-                    }
-                }
+        KmerRecordLess kmer_less{rawcnt};
+        adt::loser_tree<RecordReader::iterator, KmerRecordLess> tree(runs, kmer_less);
+        std::vector<Mpl> cnt_vector(n);
+        std::vector<seq_element_type> cur_kmer(rawcnt);
+        while (!tree.empty()) {
+            std::copy(tree.top().data(), tree.top().data() + rawcnt, cur_kmer.begin());
+            std::fill(cnt_vector.begin(), cnt_vector.end(), 0);
+            size_t cnt_min = 0, total_cnt = 0;
+            while (!tree.empty() &&
+                   std::equal(cur_kmer.begin(), cur_kmer.end(), tree.top().data())) {
+                auto cnt = tree.top().data()[rawcnt];
+                cnt_vector[tree.top_run()] = Mpl(cnt);
+                total_cnt += cnt;
+                ++cnt_min;
+                tree.replay();
             }
-            if (!min_kmer) {
-                break;
-            }
-            if (cnt_min >= all_min) {
-                std::vector<uint32> cnt_vector(n, 0);
-                size_t total_cnt = 0;
-                for (size_t i = 0; i < n; ++i) {
-                    if (alive[i] && top_kmer[i].first == *min_kmer) {
-                        auto cnt = top_kmer[i].second;
-                        cnt_vector[i] = cnt;
-                        total_cnt += cnt;
-                    }
-                }
-                if (cnt_min > 1 || total_cnt > min_mult) {
-                    min_kmer.get().BinWrite(output_kmer);
-                    for (size_t mpl : cnt_vector) {
-                        mpl_file.write(reinterpret_cast<char *>(&mpl), sizeof(Mpl));
-                    }
-                }
-            }
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i] && top_kmer[i].first == *min_kmer) {
-                    alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
-                }
+
+            if (cnt_min >= all_min && (cnt_min > 1 || total_cnt > min_mult)) {
+                RtSeq(k_, cur_kmer.data()).BinWrite(output_kmer);
+                mpl_file.write(reinterpret_cast<const char *>(cnt_vector.data()), n * sizeof(Mpl));
             }
         }
         return kmer_file;
@@ -188,7 +185,7 @@ public:
     void CombineMultiplicities(const vector<string>& input_files, size_t min_samples,
                                size_t min_mult, const string& tmpdir, size_t nthreads = 1) {
         auto workdir = fs::tmp::make_temp_dir(tmpdir, "kmidx");
-        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult);
+        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult, nthreads);
         BuildKmerIndex(workdir, kmer_file, input_files.size(), nthreads);
     }
 private:
@@ -13,6 +13,7 @@
 #include "modules/path_extend/pe_resolver.hpp"
 #include "modules/path_extend/pe_utils.hpp"
 #include "io/dataset_support/read_converter.hpp"
+#include "io/utils/buffered_ofstream.hpp"
 #include "utils/filesystem/path_helper.hpp"
 
 #include <unordered_set>
@@ -146,7 +147,7 @@ void ContigOutput::run(GraphPack &gp, const char*) {
                 io::IdNamingF<Graph>();
         std::string gfa_fn = fs::append_path(output_dir, outputs_[Kind::GFAGraph] + ".gfa");
 
-        gfa_os.reset(new std::ofstream(gfa_fn));
+        gfa_os.reset(new io::buffered_ofstream(gfa_fn));
         gfa_writer.emplace(graph, *gfa_os, naming_f);
         INFO("Writing GFA graph to " << gfa_fn);
         gfa_writer->WriteSegmentsAndLinks();
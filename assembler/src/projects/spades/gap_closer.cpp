@@ -357,6 +357,7 @@ public:
     //TODO extract methods
     void CloseShortGaps() {
         INFO("Closing short gaps");
+        omnigraph::DirtyVertexTracker<Graph> dirty_vertices(g_);
         size_t gaps_filled = 0;
         size_t gaps_checked = 0;
         for (auto edge = g_.SmartEdgeBegin(); !edge.IsEnd(); ++edge) {
@@ -391,7 +392,7 @@ public:
         INFO("Closing short gaps complete: filled " << gaps_filled
              << " gaps after checking " << gaps_checked
              << " candidates");
-        omnigraph::CompressAllVertices<Graph>(g_);
+        omnigraph::CompressDirtyVertices<Graph>(g_, dirty_vertices);
     }
 
     GapCloser(Graph &g, omnigraph::de::PairedInfoIndexT<Graph> &tips_paired_idx,
@@ -715,11 +715,12 @@ public:
 
     std::map<EdgeId, EdgeId> operator()() {
         EdgeFateTracker fate_tracker(g_);
+        omnigraph::DirtyVertexTracker<Graph> dirty_vertices(g_);
         MultiGapJoiner gap_joiner(g_);
 
         gap_joiner(ConstructConsensus());
 
-        CompressAllVertices(g_, /*chunk_cnt*/100);
+        CompressDirtyVertices(g_, dirty_vertices, /*chunk_cnt*/100);
         return fate_tracker.Old2NewMapping();
     };
 
@@ -17,6 +17,8 @@
 
 #include "io/dataset_support/read_converter.hpp"
 
+#include "utils/memory_limit.hpp"
+
 #include "adt/bf.hpp"
 #include "adt/hll.hpp"
 
@@ -31,6 +33,9 @@ using SequencingLib = io::SequencingLibrary<config::LibraryData>;
 using PairedInfoFilter = bf::counting_bloom_filter<std::pair<EdgeId, EdgeId>, 2>;
 using EdgePairCounter = hll::hll_with_hasher<std::pair<EdgeId, EdgeId>>;
 
+// Raw pair filter takes this many cells per estimated edge pair of the library
+const size_t FILTER_CELLS_PER_EDGE_PAIR = 12;
+
 std::shared_ptr<SequenceMapper<Graph>> ChooseProperMapper(const GraphPack& gp,
                                                           const SequencingLib& library) {
     const auto &graph = gp.get<Graph>();
@@ -196,28 +201,40 @@ bool ShouldObtainSingleReadsPaths(size_t ilib) {
     return false;
 }
 
-bool CollectLibInformation(const GraphPack &gp,
-                           size_t &edgepairs,
-                           size_t ilib, size_t edge_length_threshold) {
-    INFO("Estimating insert size (takes a while)");
-    InsertSizeCounter hist_counter(gp.get<Graph>(), edge_length_threshold);
-    EdgePairCounterFiller pcounter(cfg::get().max_threads);
+// Streams and mappers of paired libraries mapped together in a single notifier pass
+class PairedLibrariesBatch {
+  public:
+    void Add(size_t ilib, io::BinaryPairedStreams streams,
+             std::shared_ptr<SequenceMapper<Graph>> mapper) {
+        libs_.push_back(ilib);
+        streams_.push_back(std::move(streams));
+        mappers_.push_back(std::move(mapper));
+    }
 
-    SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
-    notifier.Subscribe(ilib, &hist_counter);
-    notifier.Subscribe(ilib, &pcounter);
+    void Process(SequenceMapperNotifier &notifier) {
+        std::vector<SequenceMapperNotifier::LibraryStreams<io::PairedReadSeq>> libs;
+        for (size_t i = 0; i < libs_.size(); ++i)
+            libs.push_back({libs_[i], &streams_[i], mappers_[i].get()});
+        notifier.ProcessLibraries(libs);
+    }
+
+  private:
+    std::vector<size_t> libs_;
+    std::vector<io::BinaryPairedStreams> streams_;
+    std::vector<std::shared_ptr<SequenceMapper<Graph>>> mappers_;
+};
 
+bool CollectLibInformation(const GraphPack &gp,
+                           const InsertSizeCounter &hist_counter,
+                           const EdgePairCounterFiller &pcounter,
+                           size_t &edgepairs, size_t ilib) {
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     auto &data = reads.data();
-    auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
-                                                /*include_merged*/true);
-
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
     //Check read length after lib processing since mate pairs a not used until this step
     VERIFY(reads.data().unmerged_read_length != 0);
 
     edgepairs = size_t(pcounter.cardinality());
-    INFO("Edge pairs: " << edgepairs);
+    INFO("Library #" << ilib << ": edge pairs: " << edgepairs);
 
     INFO(hist_counter.mapped() << " paired reads (" <<
          ((double) hist_counter.mapped() * 100.0 / (double) hist_counter.total()) <<
@@ -242,6 +259,38 @@ bool CollectLibInformation(const GraphPack &gp,
     return !data.insert_size_distribution.empty();
 }
 
+// Estimates insert size of all the given libraries in a single mapping pass
+std::vector<bool> CollectLibInformation(const GraphPack &gp,
+                                        std::vector<size_t> &edgepairs,
+                                        const std::vector<size_t> &libs,
+                                        size_t edge_length_threshold) {
+    INFO("Estimating insert size (takes a while)");
+    SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
+    std::vector<std::unique_ptr<InsertSizeCounter>> hist_counters;
+    std::vector<std::unique_ptr<EdgePairCounterFiller>> pcounters;
+    PairedLibrariesBatch batch;
+    for (size_t ilib : libs) {
+        hist_counters.emplace_back(new InsertSizeCounter(gp.get<Graph>(), edge_length_threshold));
+        pcounters.emplace_back(new EdgePairCounterFiller(cfg::get().max_threads));
+        notifier.Subscribe(ilib, hist_counters.back().get());
+        notifier.Subscribe(ilib, pcounters.back().get());
+
+        SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
+        batch.Add(ilib,
+                  paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
+                                        /*include_merged*/true),
+                  ChooseProperMapper(gp, reads));
+    }
+    batch.Process(notifier);
+
+    std::vector<bool> res(libs.size());
+    edgepairs.assign(libs.size(), 0);
+    for (size_t i = 0; i < libs.size(); ++i)
+        res[i] = CollectLibInformation(gp, *hist_counters[i], *pcounters[i], edgepairs[i], libs[i]);
+
+    return res;
+}
+
 size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
                                  bool use_binary = true, bool map_paired = false) {
     //FIXME make const
@@ -282,45 +331,84 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
 }
 
 
-void ProcessPairedReads(GraphPack &gp,
-                               std::unique_ptr<PairedInfoFilter> filter,
-                               unsigned filter_threshold,
-                               size_t ilib) {
-    SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
-    const auto &data = reads.data();
-
-    unsigned round_thr = 0;
-    // Do not round if filtering is disabled
-    if (filter)
-        round_thr = unsigned(std::min(cfg::get().de.max_distance_coeff * data.insert_size_deviation * cfg::get().de.rounding_coeff,
-                                      cfg::get().de.rounding_thr));
-
+// Filters are indexed by library, the ones of unfiltered libraries are null
+void FilterPairedReads(GraphPack &gp,
+                       std::vector<std::unique_ptr<PairedInfoFilter>> &filters,
+                       const std::vector<size_t> &libs,
+                       const std::vector<size_t> &edgepairs) {
     SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
-    INFO("Left insert size quantile " << data.insert_size_left_quantile <<
-         ", right insert size quantile " << data.insert_size_right_quantile <<
-         ", filtering threshold " << filter_threshold <<
-         ", rounding threshold " << round_thr);
-
-    LatePairedIndexFiller::WeightF weight;
-    if (filter) {
-        weight = [&](const std::pair<EdgeId, EdgeId> &ep,
-                     const MappingRange&, const MappingRange&) {
-            return (filter->lookup(ep) > filter_threshold ? 1. : 0.);
-        };
-    } else {
-        weight = [&](const std::pair<EdgeId, EdgeId> &,
-                     const MappingRange&, const MappingRange&) {
-            return 1.;
-        };
+    std::vector<std::unique_ptr<DEFilter>> filter_counters;
+    PairedLibrariesBatch batch;
+    for (size_t i = 0; i < libs.size(); ++i) {
+        size_t ilib = libs[i];
+        auto &lib = cfg::get_writable().ds.reads[ilib];
+        filters[ilib].reset(new PairedInfoFilter([](const std::pair<EdgeId, EdgeId> &e, uint64_t seed) {
+                    uint64_t h1 = e.first.hash();
+                    return XXH3_64bits_withSeed(&h1, sizeof(h1), (e.second.hash() * seed) ^ seed);
+                },
+                FILTER_CELLS_PER_EDGE_PAIR * edgepairs[i]));
+
+        INFO("Filtering data for library #" << ilib);
+        filter_counters.emplace_back(new DEFilter(*filters[ilib], gp.get<Graph>()));
+        notifier.Subscribe(ilib, filter_counters.back().get());
+
+        VERIFY(lib.data().unmerged_read_length != 0);
+        batch.Add(ilib,
+                  paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true),
+                  ChooseProperMapper(gp, lib));
     }
+    batch.Process(notifier);
+}
 
+void ProcessPairedReads(GraphPack &gp,
+                        const std::vector<std::unique_ptr<PairedInfoFilter>> &filters,
+                        unsigned filter_threshold,
+                        const std::vector<size_t> &libs) {
     using Indices = omnigraph::de::UnclusteredPairedInfoIndicesT<Graph>;
-    LatePairedIndexFiller pif(gp.get<Graph>(), weight, round_thr, gp.get_mutable<Indices>()[ilib]);
-    notifier.Subscribe(ilib, &pif);
+    SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
+    std::vector<std::unique_ptr<LatePairedIndexFiller>> fillers;
+    PairedLibrariesBatch batch;
+    for (size_t ilib : libs) {
+        SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
+        const auto &data = reads.data();
+        const PairedInfoFilter *filter = filters[ilib].get();
+
+        unsigned round_thr = 0;
+        // Do not round if filtering is disabled
+        if (filter)
+            round_thr = unsigned(std::min(cfg::get().de.max_distance_coeff * data.insert_size_deviation * cfg::get().de.rounding_coeff,
+                                          cfg::get().de.rounding_thr));
+
+        INFO("Mapping library #" << ilib);
+        INFO("Left insert size quantile " << data.insert_size_left_quantile <<
+             ", right insert size quantile " << data.insert_size_right_quantile <<
+             ", filtering threshold " << filter_threshold <<
+             ", rounding threshold " << round_thr);
+
+        LatePairedIndexFiller::WeightF weight;
+        if (filter) {
+            weight = [=](const std::pair<EdgeId, EdgeId> &ep,
+                         const MappingRange&, const MappingRange&) {
+                return (filter->lookup(ep) > filter_threshold ? 1. : 0.);
+            };
+        } else {
+            weight = [](const std::pair<EdgeId, EdgeId> &,
+                        const MappingRange&, const MappingRange&) {
+                return 1.;
+            };
+        }
+
+        fillers.emplace_back(new LatePairedIndexFiller(gp.get<Graph>(), weight, round_thr,
+                                                       gp.get_mutable<Indices>()[ilib]));
+        notifier.Subscribe(ilib, fillers.back().get());
 
-    auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
-                                                /*include merged*/true);
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+        batch.Add(ilib,
+                  paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
+                                        /*include merged*/true),
+                  ChooseProperMapper(gp, reads));
+    }
+    INFO("Mapping paired reads (takes a while) ");
+    batch.Process(notifier);
 }
 
 } // namespace
@@ -330,6 +418,7 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
     gp.EnsureBasicMapping();
 
     const auto &graph = gp.get<Graph>();
+    size_t lib_count = cfg::get().ds.reads.lib_count();
 
     //TODO implement better universal logic
     size_t edge_length_threshold = cfg::get().min_edge_length_for_is_count;
@@ -337,81 +426,121 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
         edge_length_threshold = std::max(edge_length_threshold, Nx(graph, 50));
 
     INFO("Min edge length for estimation: " << edge_length_threshold);
-    for (size_t i = 0; i < cfg::get().ds.reads.lib_count(); ++i) {
+    std::vector<size_t> paired_libs, read_libs;
+    for (size_t i = 0; i < lib_count; ++i) {
         auto &lib = cfg::get_writable().ds.reads[i];
         if (lib.is_hybrid_lib()) {
             INFO("Library #" << i << " was mapped earlier on hybrid aligning stage, skipping");
-            continue;
         } else if (lib.is_contig_lib()) {
             INFO("Mapping contigs library #" << i);
             ProcessSingleReads(gp, i, false);
         } else {
-            if (lib.is_paired()) {
-                INFO("Estimating insert size for library #" << i);
-                const auto &lib_data = lib.data();
-                size_t rl = lib_data.unmerged_read_length;
-                size_t k = cfg::get().K;
-
-                size_t edgepairs = 0;
-                if (!CollectLibInformation(gp, edgepairs, i, edge_length_threshold)) {
-                    cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
-                    WARN("Unable to estimate insert size for paired library #" << i);
-                    if (rl > 0 && rl <= k) {
-                        WARN("Maximum read length (" << rl << ") should be greater than K (" << k << ")");
-                    } else if (rl <= k * 11 / 10) {
-                        WARN("Maximum read length (" << rl << ") is probably too close to K (" << k << ")");
-                    } else {
-                        WARN("None of paired reads aligned properly. Please, check orientation of your read pairs.");
-                    }
-                    continue;
-                }
+            if (lib.is_paired())
+                paired_libs.push_back(i);
+            read_libs.push_back(i);
+        }
+    }
 
-                INFO("  Insert size = " << lib_data.mean_insert_size <<
-                     ", deviation = " << lib_data.insert_size_deviation <<
-                     ", left quantile = " << lib_data.insert_size_left_quantile <<
-                     ", right quantile = " << lib_data.insert_size_right_quantile <<
-                     ", read length = " << lib_data.unmerged_read_length);
-
-                if (lib_data.mean_insert_size < 1.1 * (double) rl)
-                    WARN("Estimated mean insert size " << lib_data.mean_insert_size
-                         << " is very small compared to read length " << rl);
-
-                std::unique_ptr<PairedInfoFilter> filter;
-                unsigned filter_threshold = cfg::get().de.raw_filter_threshold;
-
-                // Only filter paired-end libraries
-                if (filter_threshold && lib.type() == io::LibraryType::PairedEnd) {
-                    filter.reset(new PairedInfoFilter([](const std::pair<EdgeId, EdgeId> &e, uint64_t seed) {
-                                uint64_t h1 = e.first.hash();
-                                return XXH3_64bits_withSeed(&h1, sizeof(h1), (e.second.hash() * seed) ^ seed);
-                            },
-                            12 * edgepairs));
-
-                    INFO("Filtering data for library #" << i);
-                    {
-                        SequenceMapperNotifier notifier(gp, cfg::get_writable().ds.reads.lib_count());
-                        DEFilter filter_counter(*filter, graph);
-                        notifier.Subscribe(i, &filter_counter);
-
-                        VERIFY(lib.data().unmerged_read_length != 0);
-                        auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
-                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
-                    }
+    // Paired libraries are processed together: every step maps the reads of all of them in one pass
+    std::vector<bool> failed(lib_count, false), filtered(lib_count, false), mapped(lib_count, false);
+    std::vector<size_t> filter_edgepairs(lib_count, 0);
+    if (!paired_libs.empty()) {
+        INFO("Estimating insert size for " << paired_libs.size() << " paired libraries");
+        std::vector<size_t> edgepairs;
+        std::vector<bool> estimated = CollectLibInformation(gp, edgepairs, paired_libs, edge_length_threshold);
+        for (size_t j = 0; j < paired_libs.size(); ++j) {
+            size_t i = paired_libs[j];
+            auto &lib = cfg::get_writable().ds.reads[i];
+            const auto &lib_data = lib.data();
+            size_t rl = lib_data.unmerged_read_length;
+            size_t k = cfg::get().K;
+
+            if (!estimated[j]) {
+                cfg::get_writable().ds.reads[i].data().mean_insert_size = 0.0;
+                WARN("Unable to estimate insert size for paired library #" << i);
+                if (rl > 0 && rl <= k) {
+                    WARN("Maximum read length (" << rl << ") should be greater than K (" << k << ")");
+                } else if (rl <= k * 11 / 10) {
+                    WARN("Maximum read length (" << rl << ") is probably too close to K (" << k << ")");
+                } else {
+                    WARN("None of paired reads aligned properly. Please, check orientation of your read pairs.");
                 }
+                failed[i] = true;
+                continue;
+            }
 
-                INFO("Mapping library #" << i);
-                if (lib.data().mean_insert_size != 0.0) {
-                    INFO("Mapping paired reads (takes a while) ");
-                    ProcessPairedReads(gp, std::move(filter), filter_threshold, i);
-                }
+            INFO("Library #" << i <<
+                 ": insert size = " << lib_data.mean_insert_size <<
+                 ", deviation = " << lib_data.insert_size_deviation <<
+                 ", left quantile = " << lib_data.insert_size_left_quantile <<
+                 ", right quantile = " << lib_data.insert_size_right_quantile <<
+                 ", read length = " << lib_data.unmerged_read_length);
+
+            if (lib_data.mean_insert_size < 1.1 * (double) rl)
+                WARN("Estimated mean insert size " << lib_data.mean_insert_size
+                     << " is very small compared to read length " << rl);
+
+            // Only filter paired-end libraries
+            if (cfg::get().de.raw_filter_threshold && lib.type() == io::LibraryType::PairedEnd) {
+                filtered[i] = true;
+                filter_edgepairs[i] = edgepairs[j];
             }
 
-            if (ShouldObtainSingleReadsPaths(i) || ShouldObtainLibCoverage()) {
-                cfg::get_writable().use_single_reads |= ShouldObtainSingleReadsPaths(i);
-                INFO("Mapping single reads of library #" << i);
-                size_t n = ProcessSingleReads(gp, i, /*use_binary*/true, /*map_paired*/true);
-                INFO("Total paths obtained from single reads: " << n);
+            if (lib_data.mean_insert_size != 0.0)
+                mapped[i] = true;
+        }
+    }
+
+    // The raw pair filters of all the libraries mapped in one pass are alive until the
+    // pass ends, and so are the per-library paired index buffers of the fillers (the
+    // latter are about the size of the resulting indices, which are kept anyway). The
+    // filters take 2 bits per cell, so the paired libraries are split into consecutive
+    // groups whose filters fit into a half of the free memory. Each group is filtered
+    // and mapped in its own passes, a library with a larger filter is mapped alone.
+    size_t filter_memory_limit = utils::get_free_memory() / 2;
+    std::vector<std::unique_ptr<PairedInfoFilter>> filters(lib_count);
+    for (size_t group_start = 0; group_start < paired_libs.size(); ) {
+        std::vector<size_t> filtered_libs, filtered_edgepairs, mapped_libs;
+        size_t filter_memory = 0;
+        size_t j = group_start;
+        for (; j < paired_libs.size(); ++j) {
+            size_t i = paired_libs[j];
+            size_t lib_memory = FILTER_CELLS_PER_EDGE_PAIR * filter_edgepairs[i] / 4;
+            if (j > group_start && filter_memory + lib_memory > filter_memory_limit)
+                break;
+
+            filter_memory += lib_memory;
+            if (filtered[i]) {
+                filtered_libs.push_back(i);
+                filtered_edgepairs.push_back(filter_edgepairs[i]);
             }
+            if (mapped[i])
+                mapped_libs.push_back(i);
+        }
+        if (group_start > 0 || j < paired_libs.size())
+            INFO("Processing paired libraries #" << paired_libs[group_start] << " to #" << paired_libs[j - 1] <<
+                 ", filters take " << filter_memory / 1024 / 1024 << " MB");
+        group_start = j;
+
+        if (!filtered_libs.empty())
+            FilterPairedReads(gp, filters, filtered_libs, filtered_edgepairs);
+
+        if (!mapped_libs.empty())
+            ProcessPairedReads(gp, filters, cfg::get().de.raw_filter_threshold, mapped_libs);
+
+        for (size_t i : filtered_libs)
+            filters[i].reset();
+    }
+
+    for (size_t i : read_libs) {
+        if (failed[i])
+            continue;
+
+        if (ShouldObtainSingleReadsPaths(i) || ShouldObtainLibCoverage()) {
+            cfg::get_writable().use_single_reads |= ShouldObtainSingleReadsPaths(i);
+            INFO("Mapping single reads of library #" << i);
+            size_t n = ProcessSingleReads(gp, i, /*use_binary*/true, /*map_paired*/true);
+            INFO("Total paths obtained from single reads: " << n);
         }
     }
 }
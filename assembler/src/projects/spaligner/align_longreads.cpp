@@ -6,6 +6,7 @@
 
 #include "io/utils/edge_namer.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/mapped_graph.hpp"
 #include "io/reads/io_helper.hpp"
 #include "io/reads/wrapper_collection.hpp"
 #include "io/reads/multifile_reader.hpp"
@@ -14,6 +15,7 @@
 #include "io/graph/gfa_writer.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "utils/logger/log_writers.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "modules/alignment/pacbio/g_aligner.hpp"
 
 #include "mapping_printer.hpp"
@@ -21,8 +23,11 @@
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/YAMLTraits.h"
 
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <numeric>
 #include <clipp/clipp.h>
 
 using namespace std;
@@ -109,28 +114,46 @@ class LongReadsAligner {
         processed_reads_ = 0;
     }
 
+    // Reads are aligned by a pool of OpenMP tasks: the reading thread prepares
+    // the next batch while the rest of the team is busy with the current one and
+    // then joins them at the end of the batch taskgroup, so at most two batches
+    // are kept in memory and nobody spins waiting for the others
     void RunAligner() {
         auto read_stream = io::FixingWrapper(io::FileReadStream(cfg_.path_to_sequences));
-        size_t n = 0;
         size_t buffer_no = 0;
-        while (!read_stream.eof()) {
-            std::vector<io::SingleRead> read_buffer;
-            read_buffer.reserve(read_buffer_size);
-            io::SingleRead read;
-            for (size_t buf_size = 0; buf_size < read_buffer_size && !read_stream.eof(); ++buf_size) {
-                read_stream >> read;
-                read_buffer.push_back(move(read));
+        #pragma omp parallel num_threads(threads_)
+        #pragma omp single
+        {
+            auto read_buffer = ReadBatch(read_stream, buffer_no++);
+            while (!read_buffer->empty()) {
+                std::shared_ptr<std::vector<io::SingleRead>> next_buffer;
+                #pragma omp taskgroup
+                {
+                    SubmitBatch(read_buffer);
+                    next_buffer = ReadBatch(read_stream, buffer_no++);
+                }
+                read_buffer = next_buffer;
             }
-            INFO("Prepared batch " << buffer_no << " of " << read_buffer.size() << " reads.");
-            AlignBatch(read_buffer);
-            ++buffer_no;
-            n += read_buffer.size();
-            INFO("Processed " << n << " reads");
         }
+        INFO("Processed " << processed_reads_ << " reads, aligned " << aligned_reads_);
     }
 
   private:
 
+    template<class Stream>
+    std::shared_ptr<std::vector<io::SingleRead>> ReadBatch(Stream &read_stream, size_t buffer_no) {
+        auto read_buffer = std::make_shared<std::vector<io::SingleRead>>();
+        read_buffer->reserve(read_buffer_size);
+        io::SingleRead read;
+        for (size_t buf_size = 0; buf_size < read_buffer_size && !read_stream.eof(); ++buf_size) {
+            read_stream >> read;
+            read_buffer->push_back(move(read));
+        }
+        if (!read_buffer->empty())
+            INFO("Prepared batch " << buffer_no << " of " << read_buffer->size() << " reads.");
+        return read_buffer;
+    }
+
     OneReadMapping AlignRead(const io::SingleRead &read) const {
         DEBUG("Read " << read.name() << ". Current Read")
         utils::perf_counter pc;
@@ -145,29 +168,36 @@ class LongReadsAligner {
         return current_read_mapping;
     }
 
-    void AlignBatch(const vector<io::SingleRead> &reads) {
-        size_t step = 10;
-        processed_reads_ = 0;
-        aligned_reads_ = 0;
-        #pragma omp parallel for schedule(guided, 50) num_threads(threads_)
-        for (size_t i = 0 ; i < reads.size(); ++i) {
-            OneReadMapping res = AlignRead(reads[i]);
-            if (res.edge_paths.size() > 0) {
-                mapping_printer_hub_.SaveMapping(res, reads[i]);
-            }
-            #pragma omp critical(aligner)
-            {
-                if (res.edge_paths.size() > 0) {
-                    aligned_reads_ ++;
-                }
-                processed_reads_ ++;
-                if (processed_reads_ * 100 / reads.size() >= step) {
-                    INFO("Processed \% reads: " << processed_reads_ * 100 / reads.size() <<
-                         "\%, Aligned reads: " << aligned_reads_ * 100 / processed_reads_ <<
-                         "\% (" << aligned_reads_ << " out of " << processed_reads_ << ")")
-                    step += 10;
-                }
-            }
+    void ProcessRead(const io::SingleRead &read) {
+        OneReadMapping res = AlignRead(read);
+        if (res.edge_paths.size() > 0) {
+            mapping_printer_hub_.SaveMapping(res, read);
+            aligned_reads_ += 1;
+        }
+        size_t processed = ++processed_reads_;
+        if (processed % read_buffer_size == 0) {
+            size_t aligned = aligned_reads_;
+            INFO("Processed reads: " << processed <<
+                 ", Aligned reads: " << aligned * 100 / processed <<
+                 "% (" << aligned << " out of " << processed << ")")
+        }
+    }
+
+    // Alignment time grows with read length, so longest reads go first and
+    // short ones fill the gaps at the end
+    void SubmitBatch(std::shared_ptr<std::vector<io::SingleRead>> reads) {
+        if (reads->empty())
+            return;
+
+        std::vector<size_t> order(reads->size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return (*reads)[a].size() > (*reads)[b].size();
+        });
+
+        for (size_t i : order) {
+            #pragma omp task firstprivate(reads, i)
+            ProcessRead((*reads)[i]);
         }
     }
 
@@ -179,8 +209,8 @@ class LongReadsAligner {
     const int threads_;
     MappingPrinterHub mapping_printer_hub_;
 
-    int aligned_reads_;
-    int processed_reads_;
+    std::atomic<size_t> aligned_reads_;
+    std::atomic<size_t> processed_reads_;
 
 };
 
@@ -192,6 +222,11 @@ void LoadGraph(const string &saves_path, debruijn_graph::ConjugateDeBruijnGraph
         DEBUG("Segments: " << gfa.num_edges() << ", links: " << gfa.num_links());
         gfa.to_graph(g, &id_mapper);
         return;
+    } else if (fs::extension(saves_path) == ".grmap") {
+        DEBUG("Load mapped graph");
+        CHECK_FATAL_ERROR(io::binary::MappedGraphIO<debruijn_graph::ConjugateDeBruijnGraph>().LoadFile(saves_path, g),
+                          "Cannot load mapped graph " << saves_path);
+        return;
     } else {
         DEBUG("Load from saves");
         io::binary::Load(saves_path, g);
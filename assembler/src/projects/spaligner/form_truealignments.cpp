@@ -9,6 +9,7 @@
 
 #include "io/utils/edge_namer.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/mapped_graph.hpp"
 #include "io/reads/io_helper.hpp"
 #include "io/reads/wrapper_collection.hpp"
 #include "io/reads/multifile_reader.hpp"
@@ -203,6 +204,11 @@ void LoadGraph(const string &saves_path, debruijn_graph::ConjugateDeBruijnGraph
         DEBUG("Segments: " << gfa.num_edges() << ", links: " << gfa.num_links());
         gfa.to_graph(g, &id_mapper);
         return;
+    } else if (fs::extension(saves_path) == ".grmap") {
+        DEBUG("Load mapped graph");
+        CHECK_FATAL_ERROR(io::binary::MappedGraphIO<debruijn_graph::ConjugateDeBruijnGraph>().LoadFile(saves_path, g),
+                          "Cannot load mapped graph " << saves_path);
+        return;
     } else {
         INFO("Load from saves");
         io::binary::Load(saves_path, g);
@@ -65,6 +65,7 @@ static void Run(const std::string &graph_path, const std::string &dataset_desc,
 
     config::init_libs(dataset, nthreads, tmpdir);
 
+    gp.SetIndexSnapshot(fs::append_path(tmpdir, fs::filename(graph_path)));
     gp.EnsureBasicMapping();
 
     std::vector<size_t> libs(dataset.lib_count());
@@ -10,34 +10,41 @@
 namespace debruijn_graph {
 namespace coverage_profiles {
 
+const size_t EdgeProfileStorage::READ_CHUNK_SIZE;
+
 void EdgeProfileStorage::HandleDelete(EdgeId e) {
-    profiles_.erase(e);
+    if (!HasProfile(e))
+        return;
+    for (auto &column : profiles_)
+        column[e.int_id()] = 0;
+    present_[e.int_id()] = false;
 }
 
 void EdgeProfileStorage::HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) {
     RawAbundanceVector total(sample_cnt_, 0);
     for (EdgeId e : old_edges) {
-        Add(total, utils::get(profiles_, e));
+        Add(total, e);
     }
-    profiles_[new_edge] = std::move(total);
+    SetProfile(new_edge, total.begin());
 }
 
 void EdgeProfileStorage::HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
-    RawAbundanceVector total(utils::get(profiles_, edge1));
-    Add(total, utils::get(profiles_, edge2));
-    profiles_[new_edge] = std::move(total);
+    RawAbundanceVector total(sample_cnt_, 0);
+    Add(total, edge1);
+    Add(total, edge2);
+    SetProfile(new_edge, total.begin());
 }
 
 void EdgeProfileStorage::HandleSplit(EdgeId old_edge, EdgeId new_edge1, EdgeId new_edge2) {
     AbundanceVector abund = profile(old_edge);
     if (old_edge == g().conjugate(old_edge)) {
         RawAbundanceVector raw1 = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge1] = raw1;
-        profiles_[g().conjugate(new_edge1)] = std::move(raw1);
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        SetProfile(new_edge1, raw1.begin());
+        SetProfile(g().conjugate(new_edge1), raw1.begin());
+        SetProfile(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)).begin());
     } else {
-        profiles_[new_edge1] = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        SetProfile(new_edge1, MultiplyEscapeZero(abund, g().length(new_edge1)).begin());
+        SetProfile(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)).begin());
     }
 }
 
@@ -45,8 +52,10 @@ void EdgeProfileStorage::Save(std::ostream &os, const io::EdgeNamingF<Graph> &ed
     for (auto it = g().ConstEdgeBegin(true); !it.IsEnd(); ++it) {
         EdgeId e = *it;
         os << edge_namer(g(), e) << '\t';
-        auto prof = profile(e);
-        std::copy(prof.begin(), prof.end(), std::ostream_iterator<double>(os, "\t"));
+        CheckProfile(e);
+        double length = double(g().length(e));
+        for (size_t i = 0; i < sample_cnt_; ++i)
+            os << double(profiles_[i][e.int_id()]) / length << '\t';
         os << '\n';
     }
 }
@@ -61,14 +70,14 @@ void EdgeProfileStorage::Load(std::istream &is,
         ss >> label;
         EdgeId e = label_helper.edge(label);
         auto p = MultiplyEscapeZero(LoadAbundanceVector(ss), g().length(e));
-        profiles_[e] = p;
-        profiles_[g().conjugate(e)] = std::move(p);
+        SetProfile(e, p.begin());
+        SetProfile(g().conjugate(e), p.begin());
     }
 
     if (check_consistency) {
         for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
             EdgeId e = *it;
-            CHECK_FATAL_ERROR(profiles_.count(e) > 0, "Failed to load profile for one of the edges");
+            CHECK_FATAL_ERROR(HasProfile(e), "Failed to load profile for one of the edges");
         }
     }
 }
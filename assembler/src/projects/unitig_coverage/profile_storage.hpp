@@ -9,7 +9,10 @@
 #include "assembly_graph/handlers/id_track_handler.hpp"
 #include "toolchain/edge_label_helper.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <vector>
+#include <omp.h>
 
 namespace debruijn_graph {
 namespace coverage_profiles {
@@ -21,20 +24,53 @@ class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
     typedef std::vector<size_t> RawAbundanceVector;
     typedef std::vector<double> AbundanceVector;
 
+    // Number of reads mapped by a single task
+    static const size_t READ_CHUNK_SIZE = 10000;
+
     size_t sample_cnt_;
-    std::unordered_map<EdgeId, RawAbundanceVector> profiles_;
+    // Dense column-major matrix: a column of counters indexed by edge id per
+    // sample, so the tasks mapping one sample only touch its own column
+    std::vector<std::vector<size_t>> profiles_;
+    std::vector<bool> present_;
+
+    bool HasProfile(EdgeId e) const {
+        return e.int_id() < present_.size() && present_[e.int_id()];
+    }
+
+    void Reserve(EdgeId e) {
+        size_t id = e.int_id();
+        if (id < present_.size())
+            return;
+        present_.resize(id + 1, false);
+        for (auto &column : profiles_)
+            column.resize(id + 1, 0);
+    }
+
+    void CheckProfile(EdgeId e) const {
+        CHECK_FATAL_ERROR(HasProfile(e), "No profile for edge " << e.int_id());
+    }
 
-    AbundanceVector Normalize(const RawAbundanceVector &p, size_t length) const {
+    template<class It>
+    void SetProfile(EdgeId e, It begin) {
+        Reserve(e);
+        for (size_t i = 0; i < sample_cnt_; ++i, ++begin)
+            profiles_[i][e.int_id()] = *begin;
+        present_[e.int_id()] = true;
+    }
+
+    AbundanceVector Normalize(EdgeId e, size_t length) const {
+        CheckProfile(e);
         AbundanceVector answer(sample_cnt_);
         for (size_t i = 0; i < sample_cnt_; ++i) {
-            answer[i] = double(p[i]) / double(length);
+            answer[i] = double(profiles_[i][e.int_id()]) / double(length);
         }
         return answer;
     }
 
-    void Add(RawAbundanceVector &p, const RawAbundanceVector &to_add) const {
+    void Add(RawAbundanceVector &p, EdgeId e) const {
+        CheckProfile(e);
         for (size_t i = 0; i < sample_cnt_; ++i) {
-            p[i] += to_add[i];
+            p[i] += profiles_[i][e.int_id()];
         }
     }
 
@@ -57,33 +93,74 @@ class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
         return total;
     }
 
+    // Hits are accumulated in a sparse per-task column first, so that the shared
+    // column of the sample is updated once per edge per chunk
+    template<class Read, class Mapper>
+    void FillChunk(const std::vector<Read> &reads, size_t stream_id, const Mapper &mapper) {
+        std::vector<std::pair<size_t, size_t>> hits;
+        for (const auto &read : reads) {
+            for (const auto &e_mr: mapper.MapSequence(read.sequence()))
+                hits.emplace_back(e_mr.first.int_id(), e_mr.second.mapped_range.size());
+        }
+        std::sort(hits.begin(), hits.end());
+
+        auto &column = profiles_[stream_id];
+        for (size_t i = 0; i < hits.size(); ) {
+            size_t id = hits[i].first, sum = 0;
+            for (; i < hits.size() && hits[i].first == id; ++i)
+                sum += hits[i].second;
+            size_t &cnt = column[id];
+#           pragma omp atomic
+            cnt += sum;
+        }
+    }
+
+    // Reads are mapped by tasks in chunks, so a single sample could occupy all the threads
     template<class SingleStream, class Mapper>
     void Fill(SingleStream &reader, size_t stream_id, const Mapper &mapper) {
-        typename SingleStream::ReadT read;
+        typedef typename SingleStream::ReadT ReadT;
+        size_t submitted = 0;
         while (!reader.eof()) {
-            reader >> read;
+            auto chunk = std::make_shared<std::vector<ReadT>>();
+            chunk->reserve(READ_CHUNK_SIZE);
+            ReadT read;
+            while (chunk->size() < READ_CHUNK_SIZE && !reader.eof()) {
+                reader >> read;
+                chunk->push_back(std::move(read));
+            }
+
+            const Mapper *m = &mapper;
+#           pragma omp task firstprivate(chunk, stream_id, m)
+            FillChunk(*chunk, stream_id, *m);
 
-            for (const auto &e_mr: mapper.MapSequence(read.sequence())) {
-                profiles_[e_mr.first][stream_id] += e_mr.second.mapped_range.size();
+            // Do not read too far ahead of mapping
+            if (++submitted % (2 * omp_get_num_threads()) == 0) {
+#               pragma omp taskwait
             }
         }
+#       pragma omp taskwait
     };
 
 public:
     EdgeProfileStorage(const Graph &g, size_t sample_cnt) :
             omnigraph::GraphActionHandler<Graph>(g, "EdgeProfileStorage"),
-            sample_cnt_(sample_cnt) {}
+            sample_cnt_(sample_cnt), profiles_(sample_cnt) {}
 
     template<class SingleStreamList, class Mapper>
     void Fill(SingleStreamList &streams, const Mapper &mapper) {
         //Initialize profiles
+        RawAbundanceVector zero(sample_cnt_, 0);
         for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
-            profiles_[*it] = RawAbundanceVector(sample_cnt_, 0);
+            SetProfile(*it, zero.begin());
         }
 
-#       pragma omp parallel for
+#       pragma omp parallel
+#       pragma omp single
         for (size_t i = 0; i < sample_cnt_; ++i) {
-            Fill(streams[i], i, mapper);
+            auto *stream = &streams[i];
+            const Mapper *m = &mapper;
+#           pragma omp task firstprivate(i, stream, m)
+            Fill(*stream, i, *m);
         }
     }
 
@@ -92,7 +169,7 @@ public:
     }
 
     AbundanceVector profile(EdgeId e) const {
-        return Normalize(utils::get(profiles_, e), g().length(e));
+        return Normalize(e, g().length(e));
     }
 
     void HandleDelete(EdgeId e) override;
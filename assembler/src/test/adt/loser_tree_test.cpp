@@ -142,3 +142,29 @@ BOOST_AUTO_TEST_CASE(threeway2) {
     BOOST_CHECK_EQUAL(get(lt, 1), std::vector<int>({}));
     BOOST_CHECK(lt.empty());
 }
+
+BOOST_AUTO_TEST_CASE(top_run) {
+    std::vector<int> v1 = {1, 3, 5};
+    std::vector<int> v2 = {2, 3};
+    std::vector<int> v3 = {0, 5};
+    auto lt = adt::make_loser_tree({adt::make_range(v1.cbegin(), v1.cend()),
+                                    adt::make_range(v2.cbegin(), v2.cend()),
+                                    adt::make_range(v3.cbegin(), v3.cend())});
+
+    std::vector<std::pair<int, size_t>> result;
+    while (!lt.empty()) {
+        result.emplace_back(lt.top(), lt.top_run());
+        lt.replay();
+    }
+
+    BOOST_CHECK_EQUAL(result.size(), 7);
+    BOOST_CHECK(result[0] == std::make_pair(0, size_t(2)));
+    BOOST_CHECK(result[1] == std::make_pair(1, size_t(0)));
+    BOOST_CHECK(result[2] == std::make_pair(2, size_t(1)));
+    BOOST_CHECK_EQUAL(result[3].first, 3);
+    BOOST_CHECK_EQUAL(result[4].first, 3);
+    BOOST_CHECK(result[3].second != result[4].second);
+    BOOST_CHECK_EQUAL(result[5].first, 5);
+    BOOST_CHECK_EQUAL(result[6].first, 5);
+    BOOST_CHECK(result[5].second != result[6].second);
+}
@@ -71,6 +71,19 @@ TEST_F(PHMTest, collision_test) {
     }
 }
 
+TEST_F(PHMTest, batch_lookup_test) {
+    // Include some absent keys as well
+    std::vector<uint64_t> keys(vals_.begin(), vals_.begin() + 100000);
+    for (uint64_t i = 0; i < 1000; ++i)
+        keys.push_back(vals_.size() + i);
+
+    std::vector<const phm*> phms(keys.size(), &phm_);
+    std::vector<uint64_t> res(keys.size());
+    phm::lookup(phms.data(), keys.data(), keys.size(), res.data());
+    for (size_t i = 0; i < keys.size(); ++i)
+        EXPECT_EQ(res[i], phm_.lookup(keys[i]));
+}
+
 void create_console_logger() {
     using namespace logging;
 
@@ -13,6 +13,7 @@
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "utils/kmer_mph/kmer_counting_plan.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
@@ -86,6 +87,63 @@ void CheckIndex(const std::vector<std::string> &reads, const std::string &tmpdir
     }
 }
 
+TEST( KMerCountingPlan, SingleBucket ) {
+    const size_t memory = 1ull << 30;
+    auto plan = kmers::KMerCountingPlan::Create(1000, 500, 16, 1, 0, memory, 1024);
+    EXPECT_EQ(1u, plan.num_buckets);
+    EXPECT_EQ(memory / 3, plan.buffer_size);
+
+    // Configured buffer size is honored
+    plan = kmers::KMerCountingPlan::Create(1000, 500, 16, 1, 1ull << 20, memory, 1024);
+    EXPECT_EQ(1u, plan.num_buckets);
+    EXPECT_EQ(1ull << 20, plan.buffer_size);
+}
+
+TEST( KMerCountingPlan, MemoryBelowBucket ) {
+    const size_t memory = 1ull << 30, distinct = 100000000, kmer_size = 16;
+    const unsigned nthreads = 16;
+    auto plan = kmers::KMerCountingPlan::Create(10 * distinct, distinct, kmer_size, nthreads, 0, memory, 1 << 20);
+    // Fewer threads, so that both the buckets counted simultaneously and the splitting buffers fit
+    EXPECT_LT(plan.num_threads, nthreads);
+    EXPECT_LE(2 * distinct * kmer_size * plan.num_threads / plan.num_buckets, memory / 2);
+    EXPECT_LE(plan.buffer_size * plan.num_threads, memory / 3);
+    // Splitting buffer still holds a reasonable number of k-mers per bucket
+    EXPECT_GE(plan.buffer_size, 16384 * plan.num_buckets * kmer_size);
+}
+
+TEST( KMerCountingPlan, MemoryTooLow ) {
+    const size_t memory = 1ull << 20, distinct = 100000000, kmer_size = 16;
+    const unsigned nthreads = 4;
+    auto plan = kmers::KMerCountingPlan::Create(10 * distinct, distinct, kmer_size, nthreads, 0, memory, 1 << 20);
+    // Buckets cannot fit, but the splitting buffers are still kept within the limit
+    EXPECT_EQ(1u, plan.num_threads);
+    EXPECT_EQ(1u, plan.num_buckets);
+    EXPECT_LE(plan.buffer_size, memory / 3);
+}
+
+TEST( KMerCountingPlan, MergeFanIn ) {
+    const size_t memory = 64ull << 30, instances = 1000000000000ull, kmer_size = 16;
+    auto plan = kmers::KMerCountingPlan::Create(instances, instances / 100, kmer_size, 1, 0, memory, 1 << 20);
+    // The buffer grows beyond the default maximum to limit the number of runs in a bucket
+    EXPECT_GT(plan.buffer_size, 512ull << 20);
+    EXPECT_LE(plan.merge_fan_in, 4096);
+    EXPECT_LE(plan.buffer_size, memory / 3);
+}
+
+TEST( KMerCountingPlan, ManyFiles ) {
+    const size_t memory = 3ull << 29, distinct = 1000000000, kmer_size = 16;
+    const unsigned nthreads = 4;
+    // Number of buckets is limited by the open files left after the reserved ones
+    auto plan = kmers::KMerCountingPlan::Create(10 * distinct, distinct, kmer_size, nthreads, 0, memory, 200);
+    EXPECT_EQ(nthreads, plan.num_threads);
+    EXPECT_EQ(200u - 2 * nthreads - 64, plan.num_buckets);
+    EXPECT_GE(plan.buffer_size, 16384 * plan.num_buckets * kmer_size);
+
+    // Not even the reserved files are available, one bucket per thread
+    plan = kmers::KMerCountingPlan::Create(10 * distinct, distinct, kmer_size, nthreads, 0, memory, 10);
+    EXPECT_EQ(nthreads, plan.num_buckets);
+}
+
 TEST_F( GraphConstruction, TestKmerStoringIndex ) {
     std::vector<std::string> reads = { "CGAAACCAC", "CGAAAACAC", "AACCACACC", "AAACACACC" };
     CheckIndex(reads, tmp_folder(), 5);
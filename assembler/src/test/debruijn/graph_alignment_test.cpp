@@ -196,3 +196,158 @@ TEST(GraphAligner, DijkstraGrowEndsTest ) {
     int score = ends_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
 }
+
+static EdgeId EdgeByIntId(const Graph &g, size_t eid_int) {
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        if (g.int_id(*it) == eid_int)
+            return *it;
+    }
+    return EdgeId();
+}
+
+static void CheckMapping(const Graph &g, const omnigraph::MappingPath<EdgeId> &path,
+                         const std::vector<std::tuple<size_t, size_t, size_t, size_t, size_t>> &expected) {
+    ASSERT_EQ(expected.size(), path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        const auto &range = path.mapping_at(i);
+        EXPECT_EQ(std::get<0>(expected[i]), g.int_id(path.edge_at(i)));
+        EXPECT_EQ(std::get<1>(expected[i]), range.initial_range.start_pos);
+        EXPECT_EQ(std::get<2>(expected[i]), range.initial_range.end_pos);
+        EXPECT_EQ(std::get<3>(expected[i]), range.mapped_range.start_pos);
+        EXPECT_EQ(std::get<4>(expected[i]), range.mapped_range.end_pos);
+    }
+}
+
+// The read follows 17572 -> 1565 -> 20042 with two substitutions, an insertion and a deletion,
+// 1565 ends in a fork to 19391 and 20042. Expected fills were obtained with the std::set based search.
+static const std::string BRANCHING_READ = "CGTGCGTAAATAAAACCGGGTGATGCAAAAGTAGCCATTTTATTCACAAGGCCATTGACGCATCGCCCGGTTAGTTTTAACCTTGTCCACCGTGATTCACTTCGTGAACATGTCCTTTCAGGGCCGATATAGCTCAGTTGGTAGAGCAGCGCATTCGTAATGCGAAGGTCGTAGGTTCGACTCCTATTATCGGCACCATTTAAAATCAAATTGTTACGTAAGATCTTATCATTCTCCCACCAAAAAATTATCTTAATGTACCAGCTGGTGTAAGTAAATTCTATCAACGAAGATCAATCTTATCT";
+
+TEST(GraphAligner, DijkstraBranchingGapTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    std::unordered_map<VertexId, size_t> vertex_pathlen;
+    int path_maxlen = 100500;
+    EdgeId start_e = EdgeByIntId(g, 17572);
+    sensitive_aligner::GapClosingConfig gap_cfg;
+    gap_cfg.find_shortest_path = true;
+    gap_cfg.updates_limit = 10000000;
+    gap_cfg.penalty_ratio = 200;
+    gap_cfg.queue_limit = 1000000;
+    gap_cfg.iteration_limit = 1000000;
+
+    sensitive_aligner::DijkstraGapFiller gap_filler(g, gap_cfg, BRANCHING_READ, start_e, EdgeByIntId(g, 20042),
+                                                    4075, 150, path_maxlen, vertex_pathlen);
+    gap_filler.CloseGap();
+    EXPECT_EQ(0, gap_filler.return_code().status);
+    EXPECT_EQ(4, gap_filler.edit_distance());
+    CheckMapping(g, gap_filler.mapping_path(), {std::make_tuple(17572, 0, 149, 4075, 4225),
+                                                std::make_tuple(1565, 149, 154, 0, 5),
+                                                std::make_tuple(20042, 154, 305, 0, 150)});
+
+    sensitive_aligner::DijkstraGapFiller other_filler(g, gap_cfg, BRANCHING_READ, start_e, EdgeByIntId(g, 19391),
+                                                      4075, 150, path_maxlen, vertex_pathlen);
+    other_filler.CloseGap();
+    EXPECT_EQ(0, other_filler.return_code().status);
+    EXPECT_EQ(53, other_filler.edit_distance());
+    CheckMapping(g, other_filler.mapping_path(), {std::make_tuple(17572, 0, 149, 4075, 4225),
+                                                  std::make_tuple(1565, 149, 154, 0, 5),
+                                                  std::make_tuple(19391, 154, 305, 0, 150)});
+}
+
+TEST(GraphAligner, DijkstraBranchingEndsTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    int path_maxlen = 100500;
+    sensitive_aligner::EndsClosingConfig gap_cfg;
+    gap_cfg.find_shortest_path = true;
+    gap_cfg.updates_limit = 10000000;
+    gap_cfg.penalty_ratio = 0.1;
+    gap_cfg.queue_limit = 1000000;
+    gap_cfg.iteration_limit = 1000000;
+
+    sensitive_aligner::DijkstraEndsReconstructor ends_filler(g, gap_cfg, BRANCHING_READ.substr(0, 250),
+                                                             EdgeByIntId(g, 17572), 4075, path_maxlen);
+    ends_filler.CloseGap();
+    EXPECT_EQ(0, ends_filler.return_code().status);
+    EXPECT_EQ(3, ends_filler.edit_distance());
+    EXPECT_EQ(95, ends_filler.path_end_position());
+    EXPECT_EQ(250, ends_filler.seq_end_position());
+    CheckMapping(g, ends_filler.mapping_path(), {std::make_tuple(17572, 0, 149, 4075, 4225),
+                                                 std::make_tuple(1565, 149, 154, 0, 5),
+                                                 std::make_tuple(20042, 154, 250, 0, 95)});
+}
+
+static std::vector<size_t> PathIds(const Graph &g, const std::vector<EdgeId> &path) {
+    std::vector<size_t> res;
+    for (EdgeId e : path)
+        res.push_back(g.int_id(e));
+    return res;
+}
+
+TEST(GraphAligner, MyersBranchingGapTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    std::unordered_map<VertexId, size_t> vertex_pathlen;
+    EdgeId start_e = EdgeByIntId(g, 17572);
+    sensitive_aligner::GapClosingConfig gap_cfg;
+
+    sensitive_aligner::MyersGapFiller gap_filler(g, gap_cfg, BRANCHING_READ, start_e, EdgeByIntId(g, 20042),
+                                                 4075, 150, 100500, vertex_pathlen);
+    gap_filler.CloseGap();
+    EXPECT_EQ(0, gap_filler.return_code().status);
+    EXPECT_EQ(4, gap_filler.edit_distance());
+    EXPECT_EQ(std::vector<size_t>({17572, 1565, 20042}), PathIds(g, gap_filler.path()));
+
+    sensitive_aligner::MyersGapFiller other_filler(g, gap_cfg, BRANCHING_READ, start_e, EdgeByIntId(g, 19391),
+                                                   4075, 150, 100500, vertex_pathlen);
+    other_filler.CloseGap();
+    EXPECT_EQ(0, other_filler.return_code().status);
+    EXPECT_EQ(53, other_filler.edit_distance());
+    EXPECT_EQ(std::vector<size_t>({17572, 1565, 19391}), PathIds(g, other_filler.path()));
+
+    // Too tight limit
+    sensitive_aligner::MyersGapFiller tight_filler(g, gap_cfg, BRANCHING_READ, start_e, EdgeByIntId(g, 19391),
+                                                   4075, 150, 52, vertex_pathlen);
+    tight_filler.CloseGap();
+    EXPECT_TRUE(tight_filler.return_code().no_path);
+    EXPECT_FALSE(tight_filler.limits_exceeded());
+    EXPECT_EQ(std::numeric_limits<int>::max(), tight_filler.edit_distance());
+
+    // The same edge
+    std::string s = g.EdgeNucls(start_e).Subseq(100, 300).str();
+    s.erase(50, 1);
+    sensitive_aligner::MyersGapFiller one_edge_filler(g, gap_cfg, s, start_e, start_e,
+                                                      100, 300, 100500, vertex_pathlen);
+    one_edge_filler.CloseGap();
+    EXPECT_EQ(1, one_edge_filler.edit_distance());
+    EXPECT_EQ(std::vector<size_t>({17572}), PathIds(g, one_edge_filler.path()));
+}
+
+TEST(GraphAligner, MyersBranchingEndsTest ) {
+    size_t K = 55;
+    Graph g(K);
+    graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g);
+
+    sensitive_aligner::EndsClosingConfig gap_cfg;
+    sensitive_aligner::MyersEndsReconstructor ends_filler(g, gap_cfg, BRANCHING_READ.substr(0, 250),
+                                                          EdgeByIntId(g, 17572), 4075, 100500);
+    ends_filler.CloseGap();
+    EXPECT_EQ(0, ends_filler.return_code().status);
+    EXPECT_EQ(3, ends_filler.edit_distance());
+    EXPECT_EQ(95, ends_filler.path_end_position());
+    EXPECT_EQ(250, ends_filler.seq_end_position());
+    EXPECT_EQ(std::vector<size_t>({17572, 1565, 20042}), PathIds(g, ends_filler.path()));
+
+    // Falls back when the limits are exceeded
+    gap_cfg.iteration_limit = 1;
+    sensitive_aligner::MyersEndsReconstructor limited_filler(g, gap_cfg, BRANCHING_READ.substr(0, 250),
+                                                             EdgeByIntId(g, 17572), 4075, 100500);
+    limited_filler.CloseGap();
+    EXPECT_TRUE(limited_filler.limits_exceeded());
+}
@@ -5,9 +5,14 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/handlers/edges_position_handler.hpp"
+#include "adt/queue_iterator.hpp"
 
+#include <memory>
+#include <random>
 #include <vector>
 #include <set>
+#include <sstream>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -94,6 +99,48 @@ TEST( GraphCore, SmartIterator ) {
 }
 
 
+namespace {
+struct HashPriority {
+    double operator()(uint64_t x) const {
+        return double((x * 2654435761u) % 1000) / 7.;
+    }
+};
+}
+
+TEST( GraphCore, BucketedQueue ) {
+    // Last bucket is shared by the priorities above 32
+    adt::erasable_priority_queue_key_buckets<uint64_t, HashPriority, adt::quantized_buckets<2, 64>> buckets;
+    adt::erasable_priority_queue_key_dirty_heap<uint64_t, HashPriority> heap;
+    std::mt19937_64 rnd(239);
+    for (size_t i = 0; i < 20000; ++i) {
+        uint64_t x = rnd() % 500;
+        switch (rnd() % 4) {
+            case 0:
+            case 1:
+                buckets.push(x);
+                heap.push(x);
+                break;
+            case 2:
+                EXPECT_EQ(heap.erase(x), buckets.erase(x));
+                break;
+            case 3:
+                if (!heap.empty()) {
+                    EXPECT_EQ(heap.top(), buckets.top());
+                    heap.pop();
+                    buckets.pop();
+                }
+                break;
+        }
+        ASSERT_EQ(heap.size(), buckets.size());
+        if (!heap.empty()) {
+            ASSERT_EQ(heap.top(), buckets.top());
+        }
+    }
+    for (; !heap.empty(); heap.pop(), buckets.pop())
+        ASSERT_EQ(heap.top(), buckets.top());
+    EXPECT_TRUE(buckets.empty());
+}
+
 TEST( GraphCore, SelfRCEdgeMerge ) {
     Graph g(5);
     VertexId v1 = g.AddVertex();
@@ -106,3 +153,151 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+namespace {
+
+class EventRecorder : public omnigraph::GraphActionHandler<Graph> {
+    bool batchable_;
+public:
+    std::vector<std::string> events;
+
+    EventRecorder(const Graph &g, bool batchable)
+            : omnigraph::GraphActionHandler<Graph>(g, "EventRecorder"), batchable_(batchable) {}
+
+    void HandleAdd(EdgeId e) override {
+        events.push_back("add " + std::to_string(e.int_id()) + " " + std::to_string(g().length(e)));
+    }
+
+    void HandleDelete(EdgeId e) override {
+        events.push_back("delete " + std::to_string(e.int_id()) + " " + std::to_string(g().length(e)));
+    }
+
+    void HandleDelete(VertexId v) override {
+        events.push_back("delete vertex " + std::to_string(v.int_id()));
+    }
+
+    void HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) override {
+        std::string event = "merge " + std::to_string(new_edge.int_id());
+        for (EdgeId e : old_edges)
+            event += " " + std::to_string(e.int_id());
+        events.push_back(event);
+    }
+
+    bool IsBatchable() const override {
+        return batchable_;
+    }
+};
+
+}
+
+TEST( GraphCore, BatchedEvents ) {
+    Graph g(11);
+    auto data = createGraph(g, 4);
+    EventRecorder immediate(g, false), batched(g, true);
+
+    EdgeId merged;
+    {
+        omnigraph::EventBatch<Graph> batch(g);
+        merged = g.MergePath({data.second[0], data.second[1]});
+        EXPECT_FALSE(immediate.events.empty());
+        EXPECT_TRUE(batched.events.empty());
+        // Removed edges stay alive until the flush, but are not linked anymore
+        EXPECT_TRUE(g.contains(data.second[0]));
+        EXPECT_EQ(merged, g.GetUniqueOutgoingEdge(data.first[0]));
+
+        merged = g.MergePath({merged, data.second[2]});
+        EXPECT_TRUE(batched.events.empty());
+    }
+
+    EXPECT_EQ(immediate.events, batched.events);
+    EXPECT_FALSE(g.contains(data.second[0]));
+    EXPECT_FALSE(g.contains(data.first[1]));
+    EXPECT_EQ(merged, g.GetUniqueOutgoingEdge(data.first[0]));
+
+    // Handlers get the events immediately again
+    g.DeleteEdge(data.second[3]);
+    EXPECT_EQ(immediate.events, batched.events);
+}
+
+namespace {
+
+// Splits the edge into pieces, then merges the pairs of neighbouring pieces and returns the positions
+// along the resulting path
+std::vector<std::string> SplitAndMerge(Graph &g, bool batched) {
+    std::mt19937 rng(42);
+    std::string nucls;
+    for (size_t i = 0; i < 5000; ++i)
+        nucls += nucl(char(rng() % 4));
+    VertexId start = g.AddVertex();
+    EdgeId e = g.AddEdge(start, g.AddVertex(), Sequence(nucls));
+
+    omnigraph::EdgesPositionHandler<Graph> positions(g, 0);
+    positions.AddEdgePosition(e, "ref", 0, 5000, 0, 5000);
+    positions.AddEdgePosition(e, "alt", 1000, 2000, 100, 1100);
+
+    {
+        std::unique_ptr<omnigraph::EventBatch<Graph>> batch(batched ? new omnigraph::EventBatch<Graph>(g) : nullptr);
+        std::vector<EdgeId> pieces;
+        for (size_t i = 0; i < 300; ++i) {
+            auto split = g.SplitEdge(e, 1 + rng() % 15);
+            pieces.push_back(split.first);
+            e = split.second;
+        }
+        pieces.push_back(e);
+        for (size_t i = 0; i + 1 < pieces.size(); i += 2)
+            g.MergePath({pieces[i], pieces[i + 1]});
+    }
+
+    std::vector<std::string> result;
+    for (VertexId v = start; g.OutgoingEdgeCount(v) == 1; v = g.EdgeEnd(g.GetUniqueOutgoingEdge(v))) {
+        std::ostringstream ss;
+        ss << g.length(g.GetUniqueOutgoingEdge(v));
+        for (const auto &pos : positions.GetEdgePositions(g.GetUniqueOutgoingEdge(v)))
+            ss << " " << pos;
+        result.push_back(ss.str());
+    }
+    return result;
+}
+
+}
+
+TEST( GraphCore, BatchedPositions ) {
+    Graph g1(11), g2(11);
+    auto immediate = SplitAndMerge(g1, false);
+    auto batched = SplitAndMerge(g2, true);
+    EXPECT_EQ(151u, immediate.size());
+    EXPECT_EQ(immediate, batched);
+}
+
+#include "modules/simplification/compressor.hpp"
+#include <chrono>
+namespace {
+double Now() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+void Bench(int mode) {
+    // mode 0: no handler, 1: handler
+    Graph g(55);
+    std::mt19937 rng(7);
+    const size_t L = 4000000;
+    std::string nucls;
+    nucls.reserve(L);
+    for (size_t i = 0; i < L; ++i)
+        nucls += nucl(char(rng() % 4));
+    EdgeId e = g.AddEdge(g.AddVertex(), g.AddVertex(), Sequence(nucls));
+    std::unique_ptr<omnigraph::EdgesPositionHandler<Graph>> positions;
+    if (mode) {
+        positions.reset(new omnigraph::EdgesPositionHandler<Graph>(g, 0));
+        positions->AddEdgePosition(e, "ref", 0, L, 0, L);
+        positions->AddEdgePosition(g.conjugate(e), "ref_RC", 0, L, 0, L);
+    }
+    double t0 = Now();
+    for (size_t i = 0; i < 200000; ++i)
+        e = g.SplitEdge(e, 10 + rng() % 5).second;
+    double t1 = Now();
+    size_t c = omnigraph::CompressAllVertices(g);
+    double t2 = Now();
+    std::cerr << "BENCH mode=" << mode << " split=" << (t1 - t0) << " compress=" << (t2 - t1) << " merged=" << c << " edges=" << g.e_size() << "\n";
+}
+}
+TEST( GraphCore, PositionsBench ) {
+    for (int r = 0; r < 2; ++r) { Bench(0); Bench(1); }
+}
@@ -4,11 +4,16 @@
 //* See file LICENSE for details.
 //***************************************************************************
 
+#include "paired_info/compact_histogram.hpp"
 #include "paired_info/histogram.hpp"
 #include "paired_info/histptr.hpp"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <random>
+
 using namespace omnigraph::de;
 
 class alignas(2) Counter {
@@ -48,3 +53,107 @@ TEST(Histogram, StrongWeakPtrBasic) {
     //Free
     EXPECT_EQ(Counter::Count(), 0);
 }
+
+TEST(Histogram, CompactHistogramMatchesHistogram) {
+    typedef CompactHistogram<RawGapPoint> Compact;
+    Compact ch;
+    RawGapHistogram h;
+    EXPECT_TRUE(ch.empty());
+
+    //New points, weight updates, negative and non-integral values
+    std::vector<RawGapPoint> points = {
+        {10, 1}, {-3, 2}, {10, 1}, {200000, 1}, {2.5, 0.25}, {-3, 127},
+        {7, 1e-3f}, {10, 300}, {-1e7f, 1}, {0, 0}, {2.5, 1}, {123.125f, 5}
+    };
+    for (const auto &p : points) {
+        ch.merge_point(p);
+        h.merge_point(p);
+        EXPECT_EQ(h.size(), ch.size());
+        EXPECT_TRUE(std::equal(h.begin(), h.end(), ch.begin(),
+                               [](const RawGapPoint &a, const RawGapPoint &b) {
+                                   return a.d == b.d && a.weight == b.weight;
+                               }));
+    }
+    //Long stream is stored outside of the object
+    EXPECT_GT(ch.bytes_used(), sizeof(Compact));
+
+    //Backward iteration
+    std::vector<RawGapPoint> fwd(ch.begin(), ch.end()), bwd;
+    for (auto it = ch.end(); it != ch.begin(); )
+        bwd.push_back(*--it);
+    std::reverse(bwd.begin(), bwd.end());
+    ASSERT_EQ(fwd.size(), bwd.size());
+    for (size_t i = 0; i < fwd.size(); ++i) {
+        EXPECT_EQ(fwd[i].d, bwd[i].d);
+        EXPECT_EQ(fwd[i].weight, bwd[i].weight);
+    }
+
+    //Copy and erase
+    Compact copy(ch);
+    EXPECT_EQ(ch, copy);
+    EXPECT_EQ(1u, copy.erase(RawGapPoint(2.5, 0)));
+    EXPECT_EQ(0u, copy.erase(RawGapPoint(3.5, 0)));
+    EXPECT_EQ(ch.size() - 1, copy.size());
+    EXPECT_NE(ch, copy);
+
+    //Merge of histograms
+    Compact small{{1, 1}, {5, 2}};
+    EXPECT_EQ(sizeof(uint64_t), sizeof(Compact));
+    EXPECT_EQ(sizeof(Compact), small.bytes_used());
+    Compact other{{5, 3}, {6, 1}};
+    small.merge(other);
+    ASSERT_EQ(3u, small.size());
+    auto it = small.begin();
+    EXPECT_EQ(1, it->d); EXPECT_EQ(1, it->weight); ++it;
+    EXPECT_EQ(5, it->d); EXPECT_EQ(5, it->weight); ++it;
+    EXPECT_EQ(6, it->d); EXPECT_EQ(1, it->weight); ++it;
+    EXPECT_TRUE(it == small.end());
+
+    small.clear();
+    EXPECT_TRUE(small.empty());
+    EXPECT_TRUE(small.begin() == small.end());
+}
+
+TEST(Histogram, CompactHistogramLarge) {
+    typedef CompactHistogram<RawGapPoint> Compact;
+    auto same = [](const RawGapHistogram &h, const Compact &ch) {
+        if (h.size() != ch.size())
+            return false;
+        std::vector<RawGapPoint> bwd;
+        for (auto it = ch.end(); it != ch.begin(); )
+            bwd.push_back(*--it);
+        std::reverse(bwd.begin(), bwd.end());
+        auto eq = [](const RawGapPoint &a, const RawGapPoint &b) {
+            return a.d == b.d && a.weight == b.weight;
+        };
+        return std::equal(h.begin(), h.end(), ch.begin(), eq) &&
+               std::equal(h.begin(), h.end(), bwd.begin(), eq);
+    };
+
+    //Enough points for the skip directory, new ones go to the tail first
+    std::mt19937 rng(239);
+    std::normal_distribution<float> dist(0, 300);
+    Compact ch;
+    RawGapHistogram h;
+    for (size_t i = 0; i < 5000; ++i) {
+        RawGapPoint p(std::round(dist(rng)), (i % 97 == 0) ? 0.5f : 1.f);
+        ch.merge_point(p);
+        h.merge_point(p);
+        if (i % 997 == 0)
+            ASSERT_TRUE(same(h, ch)) << i;
+    }
+    ASSERT_TRUE(same(h, ch));
+
+    size_t bytes = ch.bytes_used();
+    ch.shrink_to_fit();
+    EXPECT_LE(ch.bytes_used(), bytes);
+    EXPECT_TRUE(same(h, ch));
+    //Small integral gaps and weights take a couple of bytes per point
+    EXPECT_LT(ch.bytes_used(), h.size() * sizeof(RawGapPoint) / 2);
+
+    for (size_t i = 0; i < 200; ++i) {
+        RawGapPoint p(std::round(dist(rng)), 0);
+        EXPECT_EQ(h.erase(p), ch.erase(p));
+    }
+    EXPECT_TRUE(same(h, ch));
+}
@@ -7,12 +7,16 @@
 #include "test_utils.hpp"
 #include "random_graph.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
+#include "io/binary/edge_index.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/mapped_graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 using namespace debruijn_graph;
 
 template<typename T>
@@ -63,6 +67,66 @@ TEST(Io, Order) {
     CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
 }
 
+TEST(Io, MappedGraph) {
+    const auto &graph = CommonGraph();
+
+    MappedGraphIO<Graph>().Save(file_name, graph);
+
+    Graph new_graph(graph.k());
+    EXPECT_TRUE(MappedGraphIO<Graph>().Load(file_name, new_graph));
+
+    CompareGraphIterators(graph.SmartVertexBegin(), new_graph.SmartVertexBegin());
+    CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
+    for (EdgeId e : graph.edges()) {
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(e));
+        EXPECT_EQ(graph.EdgeStart(e).int_id(), new_graph.EdgeStart(e).int_id());
+        EXPECT_EQ(graph.EdgeEnd(e).int_id(), new_graph.EdgeEnd(e).int_id());
+        EXPECT_EQ(graph.coverage_index().RawCoverage(e), new_graph.coverage_index().RawCoverage(e));
+    }
+}
+
+TEST(Io, EdgeIndexSnapshot) {
+    const auto &graph = CommonGraph();
+
+    EdgeIndex<Graph> index(graph, "tmp");
+    index.Refill();
+    EdgeIndexIO<Graph>().SaveSnapshot(file_name, index);
+
+    EdgeIndex<Graph> new_index(graph, "tmp");
+    EXPECT_TRUE(EdgeIndexIO<Graph>().LoadSnapshot(file_name, new_index));
+    for (EdgeId e : graph.edges()) {
+        auto kmer = graph.EdgeNucls(e).end<RtSeq>(index.k());
+        EXPECT_EQ(index.get(kmer), new_index.get(kmer));
+    }
+
+    Graph other_graph(graph.k());
+    EdgeIndex<Graph> other_index(other_graph, "tmp");
+    EXPECT_FALSE(EdgeIndexIO<Graph>().LoadSnapshot(file_name, other_index));
+}
+
+TEST(Io, EdgeIndexSnapshotHighFingerprint) {
+    // Pick a small graph whose fingerprint has the high bit set
+    Graph graph(55);
+    for (size_t i = 0; i < 100; ++i) {
+        graph.clear();
+        graph.AddEdge(graph.AddVertex(), graph.AddVertex(), RandomSequence(100));
+        if (omnigraph::GraphFingerprint(graph) >> 63)
+            break;
+    }
+    ASSERT_TRUE(omnigraph::GraphFingerprint(graph) >> 63);
+
+    EdgeIndex<Graph> index(graph, "tmp");
+    index.Refill();
+    EdgeIndexIO<Graph>().SaveSnapshot(file_name, index);
+
+    EdgeIndex<Graph> new_index(graph, "tmp");
+    EXPECT_TRUE(EdgeIndexIO<Graph>().LoadSnapshot(file_name, new_index));
+    for (EdgeId e : graph.edges()) {
+        auto kmer = graph.EdgeNucls(e).end<RtSeq>(index.k());
+        EXPECT_EQ(index.get(kmer), new_index.get(kmer));
+    }
+}
+
 TEST(Io, PairedInfo) {
     using namespace omnigraph::de;
     using Index = UnclusteredPairedInfoIndexT<Graph>;
@@ -109,3 +173,39 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+TEST(KmerMapper, Normalize) {
+    const auto &graph = CommonGraph();
+
+    KmerMapper<Graph> kmer_mapper(graph);
+    RandomKmerMapper<Graph>(kmer_mapper).Generate(100);
+
+    std::vector<std::pair<RtSeq, RtSeq>> expected;
+    for (auto it = kmer_mapper.begin(); it != kmer_mapper.end(); ++it)
+        expected.emplace_back(it->first, kmer_mapper.Substitute(it->first));
+    RtSeq absent = RtSeq(kmer_mapper.k(), RandomSequence(kmer_mapper.k()));
+
+    kmer_mapper.Normalize();
+    for (const auto &entry : expected) {
+        RtSeq subst = entry.first;
+        EXPECT_TRUE(kmer_mapper.CanSubstitute(entry.first));
+        EXPECT_TRUE(kmer_mapper.TrySubstitute(entry.first, subst));
+        EXPECT_EQ(entry.second, subst);
+        EXPECT_EQ(entry.second, kmer_mapper.Substitute(entry.first));
+    }
+    EXPECT_EQ(kmer_mapper.CanSubstitute(absent), kmer_mapper.Substitute(absent) != absent);
+
+    //Only the frozen map is kept, it is still iterated over
+    std::vector<std::pair<RtSeq, RtSeq>> frozen(kmer_mapper.begin(), kmer_mapper.end());
+    EXPECT_EQ(expected.size(), kmer_mapper.size());
+    std::sort(expected.begin(), expected.end());
+    std::sort(frozen.begin(), frozen.end());
+    EXPECT_EQ(expected, frozen);
+
+    //Changes go to the restored mapping
+    size_t length = kmer_mapper.k() + 10;
+    kmer_mapper.RemapKmers(RandomSequence(length), RandomSequence(length));
+    EXPECT_LT(expected.size(), kmer_mapper.size());
+    for (const auto &entry : expected)
+        EXPECT_EQ(entry.second, kmer_mapper.Substitute(entry.first));
+}
@@ -8,6 +8,7 @@
 
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
+#include "math/fft.hpp"
 //#include "io/binary/paired_index.hpp"
 
 #include <gtest/gtest.h>
@@ -458,3 +459,54 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, MergeAll) {
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+    std::vector<EdgeId> edges(graph.edges().begin(), graph.edges().end());
+    ASSERT_FALSE(edges.empty());
+
+    PairedInfoBuffersT<debruijn_graph::Graph> buffers(graph, 4);
+    for (size_t i = 0; i < 2000; ++i)
+        buffers[rand() % buffers.size()].Add(edges[rand() % edges.size()], edges[rand() % edges.size()],
+                                             RawPoint(DEDistance(rand() % 100), DEWeight(rand() % 3 + 1)));
+
+    TestIndex expected(graph), merged(graph);
+    for (auto &buffer : buffers)
+        expected.Merge(buffer);
+    merged.MergeAll(buffers, 3);
+
+    EXPECT_EQ(merged.size(), expected.size());
+    for (auto it = pair_begin(expected); it != pair_end(expected); ++it) {
+        auto hist = merged.Get(it.first(), it.second());
+        EXPECT_TRUE(std::equal((*it).begin(), (*it).end(), hist.begin(), hist.end()));
+    }
+    for (auto it = pair_begin(merged); it != pair_end(merged); ++it)
+        EXPECT_EQ((*it).size(), expected.Get(it.first(), it.second()).size());
+}
+
+TEST(PairedInfo, RealFFT) {
+    for (unsigned lg_n = 1; lg_n <= 7; ++lg_n) {
+        auto &fft = math::RealFFT::ForThread(lg_n);
+        size_t n = fft.size();
+        ASSERT_EQ(n, size_t(1) << lg_n);
+
+        std::vector<double> x(n);
+        for (size_t i = 0; i < n; ++i)
+            x[i] = double((i * 37 + 11) % 23) - 7.5;
+
+        fft.Forward(x.data());
+        for (size_t k = 0; k <= n / 2; ++k) {
+            std::complex<double> expected = 0.;
+            for (size_t i = 0; i < n; ++i)
+                expected += x[i] * std::polar(1., -2 * M_PI * double(k * i % n) / double(n));
+            EXPECT_NEAR(fft.spectrum()[k].real(), expected.real(), 1e-9) << n << " " << k;
+            EXPECT_NEAR(fft.spectrum()[k].imag(), expected.imag(), 1e-9) << n << " " << k;
+        }
+
+        std::vector<double> y(n);
+        fft.Inverse(y.data());
+        for (size_t i = 0; i < n; ++i)
+            EXPECT_NEAR(y[i], x[i], 1e-9) << n << " " << i;
+    }
+}
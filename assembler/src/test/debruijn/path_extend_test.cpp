@@ -7,6 +7,9 @@
 
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "modules/path_extend/ideal_pair_info.hpp"
+#include "modules/path_extend/weight_counter.hpp"
+#include "modules/path_extend/scaffolder2015/scaffold_graph.hpp"
 
 #include "graphio.hpp"
 
@@ -755,3 +758,118 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+TEST( PathExtend, IdealPairInfoCounter ) {
+    Graph g(21);
+    const size_t rs = 100;
+    const int k = 21;
+    std::map<int, size_t> is_distribution;
+    for (int is = 150; is < 450; ++is)
+        is_distribution[is] = 1 + (is * 7919) % 53;
+    IdealPairInfoCounter counter(g, 200, 400, rs, is_distribution);
+
+    size_t sum = 0;
+    for (const auto &entry : is_distribution)
+        sum += entry.second;
+
+    // Straightforward summation over the insert size bins, the counter rounds only once
+    auto ideal = [&](int len1, int len2, int dist) {
+        double res = 0;
+        for (const auto &entry : is_distribution) {
+            int is = entry.first;
+            if (is < 200 || is > 400)
+                continue;
+            int w;
+            if (dist == 0) {
+                w = len1 - is + 2 * int(rs) - 2 - k + 1;
+            } else {
+                int l1 = len1, l2 = len2, d = dist;
+                if (d < 0) {
+                    std::swap(l1, l2);
+                    d = -d;
+                }
+                int gap = d - l1;
+                int right = std::min(is - int(rs) - 1, gap + l2 - 1);
+                int left = std::max(gap + k + 1 - int(rs), is - 2 * int(rs) - l1 + k + 1);
+                w = std::max(right - left + 1, 0);
+            }
+            res += double(entry.second) / double(sum) * w;
+        }
+        return res;
+    };
+
+    for (int len1 : {1, 30, 79, 80, 150, 1000})
+        for (int len2 : {1, 50, 80, 300, 5000})
+            for (int dist = -1500; dist <= 1500; dist += 7) {
+                double expected = ideal(len1, len2, dist);
+                EXPECT_NEAR(counter.IdealPairedInfo(size_t(len1), size_t(len2), dist),
+                            expected, 1e-12 * std::max(1.0, std::abs(expected)))
+                        << len1 << " " << len2 << " " << dist;
+            }
+}
+
+TEST( PathExtend, PathPositionSet ) {
+    PathPositionSet positions;
+    EXPECT_TRUE(positions.empty());
+    EXPECT_EQ(positions.size(), 0);
+    EXPECT_TRUE(positions.begin() == positions.end());
+
+    std::set<size_t> expected = {0, 5, 63, 64, 65, 200};
+    for (size_t pos : expected)
+        positions.insert(pos);
+    positions.insert(5);
+
+    EXPECT_FALSE(positions.empty());
+    EXPECT_EQ(positions.size(), expected.size());
+    EXPECT_EQ(positions.count(63), 1);
+    EXPECT_EQ(positions.count(62), 0);
+    EXPECT_EQ(positions.count(1000), 0);
+    EXPECT_EQ(std::set<size_t>(positions.begin(), positions.end()), expected);
+
+    positions.clear();
+    EXPECT_TRUE(positions.empty());
+    EXPECT_EQ(positions.count(200), 0);
+    EXPECT_TRUE(positions.begin() == positions.end());
+}
+
+TEST( PathExtend, ScaffoldGraphAddRemove ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    std::vector<EdgeId> edges;
+    for (EdgeId e : g.canonical_edges())
+        if (g.conjugate(e) != e)
+            edges.push_back(e);
+    ASSERT_GE(edges.size(), 3);
+    EdgeId a = edges[0], b = edges[1], c = edges[2];
+
+    scaffold_graph::ScaffoldGraph sg(g);
+    EXPECT_TRUE(sg.AddVertex(a));
+    EXPECT_FALSE(sg.AddVertex(g.conjugate(a)));
+    sg.AddVertices({b, c});
+    EXPECT_EQ(sg.VertexCount(), 6);
+    EXPECT_TRUE(sg.IsVertexIsolated(a));
+
+    EXPECT_TRUE(sg.AddEdge(a, b, 0, 1.));
+    EXPECT_FALSE(sg.AddEdge(a, b, 0, 1.));
+    EXPECT_TRUE(sg.AddEdge(a, c, 1, 2.));
+    EXPECT_TRUE(sg.AddEdge(c, b, 0, 3.));
+    EXPECT_EQ(sg.EdgeCount(), 3);
+    EXPECT_EQ(sg.OutgoingEdgeCount(a), 2);
+    EXPECT_EQ(sg.IncomingEdgeCount(b), 2);
+    EXPECT_EQ(sg.OutgoingEdgeCount(b), 0);
+    EXPECT_TRUE(sg.HasUniqueIncoming(c));
+    EXPECT_EQ(sg.UniqueIncoming(c).getStart(), a);
+    EXPECT_EQ(sg.OutgoingEdges(a).size(), 2);
+
+    EXPECT_TRUE(sg.RemoveEdge(sg.UniqueOutgoing(c)));
+    EXPECT_FALSE(sg.Exists(scaffold_graph::ScaffoldGraph::ScaffoldEdge(c, b, 0, 3.)));
+    EXPECT_EQ(sg.EdgeCount(), 2);
+    EXPECT_EQ(sg.IncomingEdgeCount(b), 1);
+
+    EXPECT_TRUE(sg.RemoveVertex(a));
+    EXPECT_FALSE(sg.Exists(a));
+    EXPECT_FALSE(sg.Exists(g.conjugate(a)));
+    EXPECT_EQ(sg.VertexCount(), 4);
+    EXPECT_TRUE(sg.IsVertexIsolated(b));
+    EXPECT_TRUE(sg.IsVertexIsolated(c));
+}
@@ -153,6 +153,18 @@ TEST_F( Simplification,  SimpleTipClipperTest ) {
     EXPECT_EQ(4, g.size());
 }
 
+TEST_F( Simplification,  BatchedTipClipperTest ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/tipobulge/tipobulge", g));
+
+    auto info = standard_simplif_relevant_info();
+    info.set_batch_size(16);
+    debruijn::simplification::TipClipperInstance(g, standard_tc_config(), info)->Run();
+    DefaultRemoveBulges(g);
+
+    EXPECT_EQ(16, g.size());
+}
+
 TEST_F( Simplification,  SimpleBulgeRemovalTest ) {
     Graph g(55);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/simpliest_bulge/simpliest_bulge", g));
@@ -198,6 +210,20 @@ TEST_F( Simplification,  SimpleIterECTest ) {
     EXPECT_EQ(16, g.size());
 }
 
+TEST_F( Simplification,  BatchedECTest ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/iter_unique_path", g));
+
+    debruijn_config::simplification::erroneous_connections_remover ec_config;
+    ec_config.condition = "{ icb 7000 , ec_lb 20 }";
+
+    auto info = standard_simplif_relevant_info();
+    info.set_batch_size(16);
+    debruijn::simplification::ECRemoverInstance(g, ec_config, info)->Run();
+
+    EXPECT_EQ(16, g.size());
+}
+
 TEST_F( Simplification,  IterECTest ) {
     Graph g(55);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/iter_unique_path", g));
@@ -351,6 +377,59 @@ TEST_F( Simplification,  CompressorTest ) {
     EXPECT_EQ(graph.size(), graph_size);
 }
 
+TEST_F( Simplification,  DirtyVertexCompressorTest ) {
+    std::string path = "./src/test/debruijn/graph_fragments/compression/graph";
+    size_t graph_size = 12;
+    GraphPack gp(55, tmp_folder(), 0);
+    ASSERT_TRUE(graphio::ScanGraphPack(path, gp));
+    auto &graph = gp.get_mutable<Graph>();
+
+    {
+        //Vertices compressible before the tracker was attached are not visited
+        omnigraph::DirtyVertexTracker<Graph> tracker(graph);
+        size_t size = graph.size();
+        EXPECT_EQ(0u, omnigraph::CompressDirtyVertices(graph, tracker));
+        EXPECT_EQ(size, graph.size());
+    }
+
+    CompressAllVertices(graph, standard_simplif_relevant_info().chunk_cnt());
+    ASSERT_EQ(graph_size, graph.size());
+
+    auto split_two_edges = [&](omnigraph::DirtyVertexTracker<Graph> &tracker) {
+        std::vector<EdgeId> edges;
+        for (EdgeId e : graph.edges())
+            if (graph.length(e) > 10 && graph.conjugate(e) != e &&
+                (edges.empty() || (e != edges.front() && e != graph.conjugate(edges.front()))))
+                edges.push_back(e);
+        ASSERT_GE(edges.size(), 2u);
+        //The first split is made before the tracking starts, so it is only visible to the full scan
+        graph.SplitEdge(edges[1], 5);
+        tracker.clear();
+        graph.SplitEdge(edges[0], 5);
+        EXPECT_EQ(graph_size + 4, graph.size());
+        EXPECT_GT(tracker.size(), 0u);
+        //The graph is small, so the default share would fall back to the full scan
+        EXPECT_GT(tracker.size() * 4, graph.size());
+    };
+
+    omnigraph::DirtyVertexTracker<Graph> tracker(graph);
+
+    //Incremental path: only the tracked split is compressed
+    split_two_edges(tracker);
+    EXPECT_EQ(1u, omnigraph::CompressDirtyVertices(graph, tracker, 1, true, /*full_scan_share*/1.));
+    EXPECT_EQ(graph_size + 2, graph.size());
+    EXPECT_EQ(0u, tracker.size());
+    EXPECT_EQ(1u, CompressAllVertices(graph));
+    ASSERT_EQ(graph_size, graph.size());
+
+    //Full scan fallback: the untracked split is compressed as well
+    split_two_edges(tracker);
+    EXPECT_EQ(2u, omnigraph::CompressDirtyVertices(graph, tracker));
+    EXPECT_EQ(graph_size, graph.size());
+    EXPECT_EQ(0u, tracker.size());
+    EXPECT_EQ(0u, CompressAllVertices(graph));
+}
+
 #if 0
 TEST_F( Simplification,  ParallelCompressor1 ) {
     std::string path = "./src/test/debruijn/graph_fragments/compression/graph";